@@ -0,0 +1,53 @@
+#include "all_ast.h"
+#include "flat_ast.h"
+#include <iomanip>
+#include <iostream>
+
+using namespace c0;
+
+#define AST_SIZE_HELPER(name) \
+    std::cout << std::left << std::setw(20) << #name << sizeof(name) << std::endl
+
+// size of every ast node class, so that growth of the node layout is visible
+int main()
+{
+    AST_SIZE_HELPER(AST);
+    AST_SIZE_HELPER(FlatNode);
+    std::cout << std::endl;
+
+    AST_SIZE_HELPER(BinaryExprAST);
+    AST_SIZE_HELPER(CastExprAST);
+    AST_SIZE_HELPER(UnaryExprAST);
+    AST_SIZE_HELPER(BraceExprAST);
+    AST_SIZE_HELPER(IdentExprAST);
+    AST_SIZE_HELPER(IntExprAST);
+    AST_SIZE_HELPER(CharExprAST);
+    AST_SIZE_HELPER(FloatExprAST);
+    AST_SIZE_HELPER(StrExprAST);
+    AST_SIZE_HELPER(AssignExprAST);
+    AST_SIZE_HELPER(FuncCallExprAST);
+    std::cout << std::endl;
+
+    AST_SIZE_HELPER(EmptyStmtAST);
+    AST_SIZE_HELPER(BlockStmtAST);
+    AST_SIZE_HELPER(PrintStmtAST);
+    AST_SIZE_HELPER(ScanStmtAST);
+    AST_SIZE_HELPER(AssignStmtAST);
+    AST_SIZE_HELPER(FuncCallStmtAST);
+    AST_SIZE_HELPER(IfStmtAST);
+    AST_SIZE_HELPER(SwitchStmtAST);
+    AST_SIZE_HELPER(LabeledStmtAST);
+    AST_SIZE_HELPER(WhileStmtAST);
+    AST_SIZE_HELPER(DoStmtAST);
+    AST_SIZE_HELPER(ForStmtAST);
+    AST_SIZE_HELPER(BreakStmtAST);
+    AST_SIZE_HELPER(ContinueStmtAST);
+    AST_SIZE_HELPER(ReturnStmtAST);
+    std::cout << std::endl;
+
+    AST_SIZE_HELPER(VarDeclAST);
+    AST_SIZE_HELPER(FuncDeclAST);
+    AST_SIZE_HELPER(FileAST);
+
+    return 0;
+}
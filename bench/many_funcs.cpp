@@ -0,0 +1,56 @@
+#include "analyser.h"
+#include "tokenizer.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace c0;
+
+namespace
+{
+    double Seconds(std::chrono::steady_clock::time_point beg)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+    }
+}
+
+/*
+time of analysing a file of n generated functions, each one with a local
+variable assigned before it is returned, with the size doubled up to 100k.
+the time per function stays flat when the flow checks of a function cost
+its own size and not the size of the file.
+*/
+int main()
+{
+    std::cout << std::left << std::setw(10) << "funcs" << std::setw(12) << "tokenize"
+        << std::setw(12) << "analyse" << "ns/func" << std::endl;
+
+    for (std::size_t n = 100000 / 8; n <= 100000; n *= 2)
+    {
+        std::string s;
+        for (std::size_t i = 0; i < n; ++i)
+            s += "int f" + std::to_string(i) + "(int a) { int x; x = a; return x; }\n";
+        s += "int main() { return f0(0); }\n";
+
+        auto beg = std::chrono::steady_clock::now();
+        std::istringstream is(s);
+        const auto tokens = Tokenizer(is).All();
+        const auto tokenize = Seconds(beg);
+
+        beg = std::chrono::steady_clock::now();
+        AnalyseError err;
+        const auto file = Analyser(tokens).Analyse(err);
+        const auto analyse = Seconds(beg);
+        if (err)
+        {
+            std::cout << err.GetError() << std::endl;
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(10) << n << std::setw(12) << tokenize
+            << std::setw(12) << analyse << analyse * 1e9 / n << std::endl;
+    }
+
+    return 0;
+}
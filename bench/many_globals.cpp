@@ -0,0 +1,55 @@
+#include "analyser.h"
+#include "tokenizer.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace c0;
+
+namespace
+{
+    double Seconds(std::chrono::steady_clock::time_point beg)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+    }
+}
+
+/*
+time of analysing a file of n generated global constants, each one using the
+one declared before it, with the size doubled up to 100k. the time per
+declaration stays flat when declaring a name is constant time.
+*/
+int main()
+{
+    std::cout << std::left << std::setw(10) << "globals" << std::setw(12) << "tokenize"
+        << std::setw(12) << "analyse" << "ns/decl" << std::endl;
+
+    for (std::size_t n = 100000 / 8; n <= 100000; n *= 2)
+    {
+        std::string s = "const int c0 = 0;\n";
+        for (std::size_t i = 1; i < n; ++i)
+            s += "const int c" + std::to_string(i) + " = c" + std::to_string(i - 1) + " + 1;\n";
+        s += "int main() { return c" + std::to_string(n - 1) + "; }\n";
+
+        auto beg = std::chrono::steady_clock::now();
+        std::istringstream is(s);
+        const auto tokens = Tokenizer(is).All();
+        const auto tokenize = Seconds(beg);
+
+        beg = std::chrono::steady_clock::now();
+        AnalyseError err;
+        const auto file = Analyser(tokens).Analyse(err);
+        const auto analyse = Seconds(beg);
+        if (err)
+        {
+            std::cout << err.GetError() << std::endl;
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(10) << n << std::setw(12) << tokenize
+            << std::setw(12) << analyse << analyse * 1e9 / n << std::endl;
+    }
+
+    return 0;
+}
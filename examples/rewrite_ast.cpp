@@ -32,6 +32,11 @@ int main(int argc, char** argv)
     c0::AnalyseError err;
 
     auto ast = ayer.Analyse(err);
+    for (auto warning : ayer.GetWarnings())
+    {
+        warning.FixSource(tzer.GetLines());
+        std::cerr << std::to_string(warning) << std::endl;
+    }
     if (err)
     {
         err.FixSource(tzer.GetLines());
@@ -1,7 +1,40 @@
 #include "analyser.h"
+#include "sema_analyser.h"
+#include "ast_visitor.h"
+#include <array>
 
 namespace c0
 {
+    namespace
+    {
+        using LookaheadTable = std::array<Lookahead, std::size_t(TokenType::S_DIV) + 1>;
+
+        LookaheadTable MakeLookaheadTable(std::initializer_list<std::pair<TokenType, Lookahead>> items)
+        {
+            LookaheadTable table;
+            table.fill(Lookahead::Nul);
+            for (const auto& item : items)
+                table[std::size_t(item.first)] = item.second;
+            return table;
+        }
+
+        const LookaheadTable declFirstLookahead = MakeLookaheadTable({
+            {TokenType::R_CONST, Lookahead::VarDecl},
+        });
+
+        const LookaheadTable declThirdLookahead = MakeLookaheadTable({
+            {TokenType::S_ASSIGN, Lookahead::VarDecl},
+            {TokenType::S_SEMICOLON, Lookahead::VarDecl},
+            {TokenType::S_COMMA, Lookahead::VarDecl},
+            {TokenType::S_LBRACES, Lookahead::FuncDecl},
+        });
+
+        const LookaheadTable identLookahead = MakeLookaheadTable({
+            {TokenType::S_ASSIGN, Lookahead::Assign},
+            {TokenType::S_LBRACES, Lookahead::FuncCall},
+        });
+    }
+
     void AnalyseError::FixSource(const std::vector<std::string>& lines)
     {
         const auto& pos = _token.GetPosRange().first;
@@ -17,10 +50,378 @@ namespace c0
     }
 
     FileASTPtr Analyser::Analyse(AnalyseError& err)
+    {
+        _warnings.clear();
+        auto file = Parse(err);
+        if (err)
+            return file;
+
+        SemaAnalyser sema(_tokens);
+        sema.Analyse(file, err);
+        _warnings = sema.GetWarnings();
+        return file;
+    }
+
+    FileASTPtr Analyser::Analyse(const DeclCallback& callback, bool isRelease, AnalyseError& err)
+    {
+        SemaAnalyser sema(_tokens);
+        auto file = AnalyseFile(err, [&](const DeclASTPtr& decl)
+        {
+            return sema.AnalyseTopDecl(_file, decl, err) && callback(decl);
+        }, isRelease);
+        _warnings = sema.GetWarnings();
+        return file;
+    }
+
+    FileASTPtr Analyser::Parse(AnalyseError& err)
     {
         return AnalyseFile(err);
     }
 
+    FileASTPtr Analyser::Reanalyse(FileASTPtr file, const TokenList& oldTokens, const posrange_t& edit, AnalyseError& err)
+    {
+        _file = file;
+        _warnings.clear();
+        _undos.clear();
+        _replaced.clear();
+
+        DeclRangeList oldDecls;
+        DeclRangeList newDecls;
+        if (nullptr == file
+            || file->IsFrozen()
+            || file->GetContext().GetDeadNodeCount() * 2 > file->GetContext().GetNodeCount()
+            || file->GetSymbolTable().GetDeadScopeCount() * 2 > file->GetSymbolTable().GetScopeCount()
+            || !ScanDecls(oldTokens, oldDecls)
+            || !ScanDecls(_tokens, newDecls))
+            return Analyse(err);
+
+        // declarations entirely before or after edit are unchanged
+        std::size_t prefix = 0;
+        while (prefix < oldDecls.size() && prefix < newDecls.size()
+            && _tokens[newDecls[prefix].end - 1].GetPosRange().second < edit.first)
+            ++prefix;
+
+        std::size_t suffix = 0;
+        while (suffix < oldDecls.size() - prefix && suffix < newDecls.size() - prefix
+            && _tokens[newDecls[newDecls.size() - suffix - 1].beg].GetPosRange().first > edit.second)
+            ++suffix;
+
+        if (oldDecls.size() != newDecls.size())
+            return Analyse(err);
+
+        const auto& vars = file->GetVars();
+        const auto& funcs = file->GetFuncs();
+        std::size_t varIdx = 0;
+        std::size_t funcIdx = 0;
+        auto isFull = false;
+        for (std::size_t i = 0, N = oldDecls.size(); i < N && !isFull && !err; ++i)
+        {
+            const auto& oldRange = oldDecls[i];
+            const auto& newRange = newDecls[i];
+            // unchanged declarations after edit only move in the token stream
+            const auto isMoved = (i >= N - suffix);
+            const auto delta = std::ptrdiff_t(newRange.beg) - std::ptrdiff_t(oldRange.beg);
+            if (oldRange.isFunc != newRange.isFunc)
+            {
+                isFull = true;
+            }
+            else if (oldRange.isFunc)
+            {
+                if (funcIdx >= funcs.size())
+                    isFull = true;
+                else if (isMoved)
+                    MoveDecl(funcs[funcIdx], delta);
+                else if (i >= prefix)
+                    isFull = !ReanalyseFuncDecl(file, funcs[funcIdx], oldTokens, oldRange, newRange, err);
+                ++funcIdx;
+            }
+            else
+            {
+                std::vector<std::size_t> heads;
+                std::vector<std::size_t> inits;
+                SplitVarDecl(oldTokens, oldRange, heads, inits);
+                if (varIdx + inits.size() > vars.size())
+                {
+                    isFull = true;
+                }
+                else if (isMoved)
+                {
+                    for (std::size_t j = 0, M = inits.size(); j < M; ++j)
+                        MoveDecl(vars[varIdx + j], delta);
+                }
+                else if (i >= prefix)
+                {
+                    isFull = !ReanalyseVarDecl(file, oldTokens, oldRange, newRange, varIdx, err);
+                }
+                varIdx += inits.size();
+            }
+        }
+
+        if (isFull)
+        {
+            UndoReanalyse();
+            _cur = 0;
+            err = AnalyseError();
+            return Analyse(err);
+        }
+        if (err)
+            UndoReanalyse();
+        for (const auto& ast : _replaced)
+            AddDead(file, *ast);
+        _undos.clear();
+        _replaced.clear();
+        return file;
+    }
+
+    bool Analyser::ReanalyseVarDecl(FileASTPtr file, const TokenList& oldTokens,
+        const DeclRange& oldRange, const DeclRange& newRange, std::size_t varIdx, AnalyseError& err)
+    {
+        std::vector<std::size_t> oldHeads;
+        std::vector<std::size_t> oldInits;
+        SplitVarDecl(oldTokens, oldRange, oldHeads, oldInits);
+
+        std::vector<std::size_t> newHeads;
+        std::vector<std::size_t> newInits;
+        SplitVarDecl(_tokens, newRange, newHeads, newInits);
+
+        // only initializer expressions may change, anything else changes the symbols
+        if (oldHeads.size() != newHeads.size())
+            return false;
+        for (std::size_t i = 0, N = oldHeads.size(); i < N; ++i)
+        {
+            if (!IsSameToken(oldTokens[oldHeads[i]], _tokens[newHeads[i]]))
+                return false;
+        }
+
+        std::vector<std::size_t> oldNames;
+        std::vector<std::size_t> newNames;
+        for (std::size_t i = 0, N = oldHeads.size(); i < N; ++i)
+        {
+            if (oldTokens[oldHeads[i]].GetType() == TokenType::IDENT)
+            {
+                oldNames.push_back(oldHeads[i]);
+                newNames.push_back(newHeads[i]);
+            }
+        }
+
+        const auto& vars = file->GetVars();
+        for (std::size_t i = 0, N = newInits.size(); i < N; ++i)
+        {
+            const auto& var = vars[varIdx + i];
+            MoveDecl(var, std::ptrdiff_t(newNames[i]) - std::ptrdiff_t(oldNames[i]));
+            if (0 == newInits[i])
+                continue;
+
+            _cur = newInits[i];
+            auto expr = AnalyseExpr(file.get(), err);
+            if (err)
+                return true;
+            if (PeekToken().GetType() != TokenType::S_COMMA
+                && PeekToken().GetType() != TokenType::S_SEMICOLON)
+            {
+                err = AnalyseError("invalid variable declare", PeekToken());
+                return true;
+            }
+
+            // global variable can only use global variables declared before it
+            const auto oldExpr = var->GetExpr();
+            var->SetExpr(expr);
+            _undos.push_back([var, oldExpr]() { var->SetExpr(oldExpr); });
+            if (nullptr != oldExpr)
+                _replaced.push_back(oldExpr);
+            if (!SemaAnalyser(_tokens).AnalyseDecl(file, var, err))
+                return true;
+        }
+
+        return true;
+    }
+
+    bool Analyser::ReanalyseFuncDecl(FileASTPtr file, FuncDeclASTPtr func, const TokenList& oldTokens,
+        const DeclRange& oldRange, const DeclRange& newRange, AnalyseError& err)
+    {
+        // only function body may change, signature change affects the callers
+        if (oldRange.body - oldRange.beg != newRange.body - newRange.beg)
+            return false;
+        for (std::size_t i = 0, N = oldRange.body - oldRange.beg; i < N; ++i)
+        {
+            if (!IsSameToken(oldTokens[oldRange.beg + i], _tokens[newRange.beg + i]))
+                return false;
+        }
+
+        MoveDecl(func, std::ptrdiff_t(newRange.beg) - std::ptrdiff_t(oldRange.beg));
+
+        _cur = newRange.body;
+        auto block = AnalyseBlockStmt(func, err, false, false);
+        if (err)
+            return true;
+
+        const auto oldBlock = func->GetBlockStmt();
+        func->SetBlockStmt(block);
+        _undos.push_back([func, oldBlock]() { func->SetBlockStmt(oldBlock); });
+        if (nullptr != oldBlock)
+            _replaced.push_back(oldBlock);
+        SemaAnalyser sema(_tokens);
+        sema.AnalyseDecl(file, func, err);
+        _warnings.insert(_warnings.end(), sema.GetWarnings().begin(), sema.GetWarnings().end());
+        return true;
+    }
+
+    void Analyser::ShiftTokenIndex(ASTPtr ast, std::ptrdiff_t delta)
+    {
+        class Shifter : public StaticASTVisitor<Shifter>
+        {
+        public:
+            Shifter(std::ptrdiff_t delta) : _delta(delta) {}
+
+            void Visit(const AST& ast)
+            {
+                const auto token = std::ptrdiff_t(ast.GetTokenIndex()) + _delta;
+                const_cast<AST&>(ast).SetTokenIndex(std::size_t(token));
+                StaticASTVisitor<Shifter>::Visit(ast);
+            }
+
+        private:
+            std::ptrdiff_t _delta;
+        };
+
+        if (0 == delta)
+            return;
+        Shifter shifter(delta);
+        shifter.Visit(*ast);
+    }
+
+    void Analyser::MoveDecl(ASTPtr ast, std::ptrdiff_t delta)
+    {
+        ShiftTokenIndex(ast, delta);
+        _undos.push_back([ast, delta]() { ShiftTokenIndex(ast, -delta); });
+    }
+
+    void Analyser::UndoReanalyse()
+    {
+        for (auto it = _undos.rbegin(); it != _undos.rend(); ++it)
+            (*it)();
+        _undos.clear();
+        _replaced.clear();
+        _warnings.clear();
+    }
+
+    void Analyser::AddDead(FileASTPtr file, const AST& ast)
+    {
+        class Counter : public StaticASTVisitor<Counter>
+        {
+        public:
+            void Visit(const AST& ast)
+            {
+                ++nodes;
+                if (ast.GetASTType() == ASTType::BlockStmt)
+                    ++scopes;
+                StaticASTVisitor<Counter>::Visit(ast);
+            }
+
+            std::size_t nodes = 0;
+            std::size_t scopes = 0;
+        };
+
+        Counter counter;
+        counter.Visit(ast);
+        file->GetContext().AddDeadNodes(counter.nodes);
+        // a function body has its own block scopes and the one of its function entered again
+        if (ast.GetASTType() == ASTType::BlockStmt)
+            file->GetSymbolTable().AddDeadScopes(counter.scopes + 1);
+    }
+
+    bool Analyser::IsSameToken(const Token& a, const Token& b)
+    {
+        return a.GetType() == b.GetType()
+            && a.GetString() == b.GetString()
+            && a.GetInt() == b.GetInt()
+            && a.GetChar() == b.GetChar()
+            && a.GetFloat() == b.GetFloat();
+    }
+
+    /*
+    split the token stream into top-level declarations the same way as
+    AnalyseFuncSigns, without analysing anything.
+    */
+    bool Analyser::ScanDecls(const TokenList& tokens, DeclRangeList& decls)
+    {
+        const auto N = tokens.size();
+        auto canParseVarDecl = true;
+        for (std::size_t i = 0; i < N;)
+        {
+            DeclRange range = { false, i, i, i };
+            const auto third = (i + 2 < N ? tokens[i + 2].GetType() : TokenType::NUL);
+            if (canParseVarDecl
+                && GetDeclLookahead(tokens[i].GetType(), third) == Lookahead::VarDecl)
+            {
+                for (; i < N && tokens[i].GetType() != TokenType::S_SEMICOLON; ++i)
+                    ;
+                if (i == N)
+                    return false;
+                range.end = ++i;
+                decls.push_back(range);
+                continue;
+            }
+
+            canParseVarDecl = false;
+            range.isFunc = true;
+            for (; i < N && tokens[i].GetType() != TokenType::S_LPARENTHESES; ++i)
+                ;
+            range.body = i;
+
+            std::size_t depth = 0;
+            for (; i < N; ++i)
+            {
+                if (tokens[i].GetType() == TokenType::S_LPARENTHESES)
+                    ++depth;
+                else if (tokens[i].GetType() == TokenType::S_RPARENTHESES && 0 == --depth)
+                    break;
+            }
+            if (i == N)
+                return false;
+            range.end = ++i;
+            decls.push_back(range);
+        }
+        return true;
+    }
+
+    /*
+    heads are the token positions outside of initializer expressions,
+    inits are the token positions of initializer expression for each
+    declared variable, 0 if the variable has no initializer.
+    */
+    void Analyser::SplitVarDecl(const TokenList& tokens, const DeclRange& range,
+        std::vector<std::size_t>& heads, std::vector<std::size_t>& inits)
+    {
+        for (auto i = range.beg; i < range.end; ++i)
+        {
+            heads.push_back(i);
+
+            const auto type = tokens[i].GetType();
+            if (type == TokenType::IDENT)
+            {
+                inits.push_back(0);
+            }
+            else if (type == TokenType::S_ASSIGN && !inits.empty())
+            {
+                inits.back() = i + 1;
+
+                std::size_t depth = 0;
+                for (++i; i < range.end; ++i)
+                {
+                    const auto t = tokens[i].GetType();
+                    if (t == TokenType::S_LBRACES)
+                        ++depth;
+                    else if (t == TokenType::S_RBRACES && depth > 0)
+                        --depth;
+                    else if (0 == depth && (t == TokenType::S_COMMA || t == TokenType::S_SEMICOLON))
+                        break;
+                }
+                --i;
+            }
+        }
+    }
+
     Token Analyser::PeekToken(size_t offset) const
     {
         const auto pos = _cur + offset;
@@ -48,61 +449,155 @@ namespace c0
         for (; token.GetType() == TokenType::S_SEMICOLON; token = PeekToken())
             ReadToken();
     }
+
+    /*
+    top-level declaration: 'const' at first token, or '=', ';', ',' at third
+    token begins a variable declaration, anything else a function definition
+    */
+    Lookahead Analyser::GetDeclLookahead(TokenType first, TokenType third)
+    {
+        const auto firstLA = declFirstLookahead[std::size_t(first)];
+        if (Lookahead::Nul != firstLA)
+            return firstLA;
+        const auto thirdLA = declThirdLookahead[std::size_t(third)];
+        if (Lookahead::Nul != thirdLA)
+            return thirdLA;
+        return Lookahead::FuncDecl;
+    }
+
+    /*
+    identifier in statement: IDENT '=' begins an assignment, IDENT '(' a function call
+    */
+    Lookahead Analyser::GetIdentLookahead(TokenType next)
+    {
+        return identLookahead[std::size_t(next)];
+    }
+
+    void Analyser::SkipVarDecl()
+    {
+        for (auto token = ReadToken(); !token.IsNul(); token = ReadToken())
+        {
+            if (token.GetType() == TokenType::S_SEMICOLON)
+                break;
+        }
+    }
+
+    bool Analyser::SkipBlock()
+    {
+        if (PeekToken().GetType() != TokenType::S_LPARENTHESES)
+            return false;
+
+        std::size_t depth = 0;
+        for (auto token = ReadToken(); !token.IsNul(); token = ReadToken())
+        {
+            if (token.GetType() == TokenType::S_LPARENTHESES)
+                ++depth;
+            else if (token.GetType() == TokenType::S_RPARENTHESES && 0 == --depth)
+                return true;
+        }
+        return false;
+    }
     
     /*
     <C0-program> ::=
         {<variable-declaration>}{<function-definition>}
     */
-    FileASTPtr Analyser::AnalyseFile(AnalyseError& err)
+    FileASTPtr Analyser::AnalyseFile(AnalyseError& err, const DeclCallback& callback, bool isRelease)
     {
         auto file = std::make_shared<FileAST>(nullptr);
+        _file = file;
 
-        auto canParseVarDecl = true;
-        for (auto token = PeekToken(); !token.IsNul(); token = PeekToken())
+        const auto signs = AnalyseFuncSigns(file, err);
+        if (err)
+            return file;
+
+        const auto varEnd = signs.empty() ? _tokens.size() : signs.front().beg;
+        while (_cur < varEnd)
         {
-            if (canParseVarDecl)
+            auto varlist = AnalyseVarDecl(file.get(), err);
+            if (err)
+                return file;
+            for (const auto& var : varlist)
             {
-                const auto peek = PeekToken(2);
-                if (token.GetType() == TokenType::R_CONST
-                    || peek.GetType() == TokenType::S_ASSIGN
-                    || peek.GetType() == TokenType::S_SEMICOLON
-                    || peek.GetType() == TokenType::S_COMMA)
-                {
-                    auto varlist = AnalyseVarDecl(file, err);
-                    if (err)
-                        return file;
-                    for (const auto& var : varlist)
-                        file->AddVar(var);
-                    continue;
-                }
+                file->AddVar(var);
+                if (nullptr != callback && !callback(var))
+                    return file;
+                // nodes of initializer are interleaved with the declarations, left in context, see Analyse
+                if (isRelease)
+                    var->SetExpr(nullptr);
             }
+        }
 
-            canParseVarDecl = false;
-            auto func = AnalyseFuncDecl(file, err);
+        auto& context = file->GetContext();
+        auto& symbols = file->GetSymbolTable();
+        for (const auto& sign : signs)
+        {
+            const auto mark = context.GetMark();
+            const auto scopeMark = symbols.GetMark();
+            _cur = sign.body;
+            auto block = AnalyseBlockStmt(sign.func, err, false, false);
             if (err)
                 return file;
-            file->AddFunc(func);
+            sign.func->SetBlockStmt(block);
+            if (nullptr != callback && !callback(sign.func))
+                return file;
+            if (isRelease)
+            {
+                sign.func->SetBlockStmt(nullptr);
+                context.Rewind(mark);
+                symbols.Rewind(scopeMark);
+            }
         }
 
         return file;
     }
 
-    ExprASTPtr Analyser::CheckInexplicitTypeCast(ASTPtr parent, AnalyseError& err, const Token& token, 
-        ExprASTPtr fromExpr, VarType toType, const str_t& extralog)
+    /*
+    pre-pass over the token stream before any function body is analysed:
+    global variable declarations and function bodies are skipped, only
+    function signatures are analysed and added to file, so that a function
+    can be called before its definition.
+    */
+    Analyser::FuncSignList Analyser::AnalyseFuncSigns(FileASTPtr file, AnalyseError& err)
     {
-        if (fromExpr->GetVarType() == toType)
-            return fromExpr;
+        FuncSignList signs;
+        const auto readPos = _cur;
 
-        if (!IsVarTypeCastable(fromExpr->GetVarType(), toType))
+        auto canParseVarDecl = true;
+        for (auto token = PeekToken(); !token.IsNul(); token = PeekToken())
         {
-            err = AnalyseError(extralog + "cannot inexplicit cast type from '"
-                + std::to_string(fromExpr->GetVarType()) + "' to '"
-                + std::to_string(toType) + "'", token);
-            return nullptr;
+            if (canParseVarDecl
+                && GetDeclLookahead(token.GetType(), PeekToken(2).GetType()) == Lookahead::VarDecl)
+            {
+                SkipVarDecl();
+                continue;
+            }
+
+            canParseVarDecl = false;
+            FuncSign sign;
+            sign.beg = _cur;
+            sign.func = AnalyseFuncSign(file.get(), err);
+            if (err)
+                return signs;
+            sign.body = _cur;
+
+            if (!SkipBlock())
+            {
+                _cur = sign.body;
+                token = PeekToken();
+                if (token.GetType() != TokenType::S_LPARENTHESES)
+                    err = AnalyseError("expect '{' at block begin", token);
+                else
+                    err = AnalyseError("expect '}' at block end", _tokens.back());
+                return signs;
+            }
+
+            file->AddFunc(sign.func);
+            signs.push_back(sign);
         }
-        auto cast = std::make_shared<CastExprAST>(parent, fromExpr, toType, false);
-        cast->GetExpr()->SetParent(cast);
-        return cast;
+
+        _cur = readPos;
+        return signs;
     }
 }
 
@@ -114,7 +609,7 @@ namespace std
         if (!err)
             return "no error. " + to_string(token);
 
-        return "error: " + err.GetError() + ". " + to_string(token) + "\n"
+        return (err.IsWarning() ? "warning: " : "error: ") + err.GetError() + ". " + to_string(token) + "\n"
             + err.GetSrc() + std::string(token.GetPosRange().first.second, ' ') + "^";
     }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "tokenizer.h"
 #include "all_ast.h"
+#include <functional>
 
 namespace c0
 {
@@ -8,9 +9,12 @@ namespace c0
     {
     public:
         AnalyseError() = default;
-        AnalyseError(str_t err, Token token) : _valid(true), _err(err), _token(token) {}
+        AnalyseError(str_t err, Token token, bool isWarning = false)
+            : _valid(true), _isWarning(isWarning), _err(err), _token(token)
+        {}
 
         operator bool() const { return _valid; }
+        bool IsWarning() const { return _isWarning; }
 
         const str_t& GetError() const { return _err; }
         const Token& GetToken() const { return _token; }
@@ -20,29 +24,145 @@ namespace c0
 
     private:
         bool _valid = false;
+        bool _isWarning = false;
         str_t _err;
         Token _token;
         str_t _src;
     };
 
+    /*
+    all the errors of a pass going on after the first one, and problems
+    found that do not stop the analyse, e.g. unreachable code
+    */
+    using AnalyseErrorList = std::vector<AnalyseError>;
+    using AnalyseWarningList = std::vector<AnalyseError>;
+
+    /*
+    what the next tokens begin, decided by token types only
+    */
+    enum class Lookahead : std::uint8_t
+    {
+        Nul,
+        VarDecl,
+        FuncDecl,
+        Assign,
+        FuncCall,
+    };
+
+    /*
+    invoked with each analysed top-level declaration, return false to stop analysing
+    */
+    using DeclCallback = std::function<bool(const DeclASTPtr& decl)>;
+
     class Analyser
     {
     public:
         Analyser(const TokenList& tokens) : _tokens(tokens) {}
 
+        /*
+        syntax analyse and semantic analyse
+        */
         FileASTPtr Analyse(AnalyseError& err);
 
+        /*
+        streaming analyse: callback is invoked with each top-level declaration as
+        soon as it is analysed, global variables first and then functions in
+        source order. if isRelease is set, the initializer of a global variable
+        and the body of a function are released after callback, only the
+        declarations are kept in the returned file for later symbol lookup.
+
+        memory is bounded by the largest function body, not by the file, only
+        for the bodies: their nodes and scopes are rewound after callback. the
+        signatures of all functions are analysed up front, as a function may
+        be called before its definition, and a released initializer is only
+        unlinked, its nodes stay in the context among those of the global
+        declarations, so both grow with the file.
+        */
+        FileASTPtr Analyse(const DeclCallback& callback, bool isRelease, AnalyseError& err);
+
+        /*
+        syntax analyse only, the result is neither symbol checked nor typed
+        and has no implicit cast, run SemaAnalyser on it when needed.
+        */
+        FileASTPtr Parse(AnalyseError& err);
+
+        /*
+        reanalyse file, which was analysed from oldTokens, after the source text in
+        edit (position range in the new source) was changed. file is updated in
+        place: a function touched by edit gets a new body and a global variable
+        touched by edit new initializers, declarations after edit have their
+        token positions moved. a full analyse is done when the change may affect
+        other declarations, when file is frozen, or when the nodes or scopes of
+        the bodies replaced so far outnumber those in use, so repeated edits
+        keep file within about twice its size. on error, or before falling
+        back to the full analyse, every change is undone and file is left as
+        analysed from oldTokens.
+        */
+        FileASTPtr Reanalyse(FileASTPtr file, const TokenList& oldTokens, const posrange_t& edit, AnalyseError& err);
+
+        /*
+        warnings of the last Analyse, or of the declarations analysed again
+        by the last Reanalyse
+        */
+        const AnalyseWarningList& GetWarnings() const { return _warnings; }
+
     private:
+        struct FuncSign
+        {
+            FuncDeclASTPtr func;
+            std::size_t beg;    // token position of function definition
+            std::size_t body;   // token position of function body '{'
+        };
+        using FuncSignList = std::vector<FuncSign>;
+
+        struct DeclRange
+        {
+            bool isFunc;
+            std::size_t beg;    // token position of declaration
+            std::size_t body;   // token position of function body '{'
+            std::size_t end;    // token position after declaration
+        };
+        using DeclRangeList = std::vector<DeclRange>;
+
+        static bool IsSameToken(const Token& a, const Token& b);
+        static bool ScanDecls(const TokenList& tokens, DeclRangeList& decls);
+        static void SplitVarDecl(const TokenList& tokens, const DeclRange& range,
+            std::vector<std::size_t>& heads, std::vector<std::size_t>& inits);
+        bool ReanalyseVarDecl(FileASTPtr file, const TokenList& oldTokens,
+            const DeclRange& oldRange, const DeclRange& newRange, std::size_t varIdx, AnalyseError& err);
+        bool ReanalyseFuncDecl(FileASTPtr file, FuncDeclASTPtr func, const TokenList& oldTokens,
+            const DeclRange& oldRange, const DeclRange& newRange, AnalyseError& err);
+        static void ShiftTokenIndex(ASTPtr ast, std::ptrdiff_t delta);
+        void MoveDecl(ASTPtr ast, std::ptrdiff_t delta);
+        void UndoReanalyse();
+        static void AddDead(FileASTPtr file, const AST& ast);
+
+    private:
+        template<typename T, typename... Args>
+        T* NewAST(std::size_t token, Args&&... args)
+        {
+            auto ast = _file->GetContext().New<T>(std::forward<Args>(args)...);
+            ast->SetTokenIndex(token);
+            return ast;
+        }
+
         Token PeekToken(size_t offset = 0) const;
         Token ReadToken();
         void UnreadToken(size_t num = 1);
         void SkipSemiColon();
+        static Lookahead GetDeclLookahead(TokenType first, TokenType third);
+        static Lookahead GetIdentLookahead(TokenType next);
+        void SkipVarDecl();
+        bool SkipBlock();
 
         /*
         <C0-program> ::=
             {<variable-declaration>}{<function-definition>}
+
+        callback, if any, is invoked with each top-level declaration once it is parsed,
+        with isRelease the parsed function body is destroyed after callback.
         */
-        FileASTPtr AnalyseFile(AnalyseError& err);
+        FileASTPtr AnalyseFile(AnalyseError& err, const DeclCallback& callback = nullptr, bool isRelease = false);
 
         //---------------------------------------------------------------------
 
@@ -58,6 +178,14 @@ namespace c0
         */
         VarDeclASTPtrList AnalyseVarDecl(ASTPtr parent, AnalyseError& err);
         
+        /*
+        pre-pass over the token stream before any function body is analysed:
+        global variable declarations and function bodies are skipped, only
+        function signatures are analysed and added to file, so that a function
+        can be called before its definition.
+        */
+        FuncSignList AnalyseFuncSigns(FileASTPtr file, AnalyseError& err);
+
         /*
         <function-definition> ::=
             <type-specifier><identifier><parameter-clause><compound-statement>
@@ -66,8 +194,11 @@ namespace c0
             '(' [<parameter-declaration-list>] ')'
         <parameter-declaration-list> ::=
             <parameter-declaration>{','<parameter-declaration>}
+
+        only <type-specifier><identifier><parameter-clause> is analysed,
+        the <compound-statement> is left for AnalyseFile.
         */
-        FuncDeclASTPtr AnalyseFuncDecl(ASTPtr parent, AnalyseError& err);
+        FuncDeclASTPtr AnalyseFuncSign(ASTPtr parent, AnalyseError& err);
 
         /*
         <parameter-declaration> ::= 
@@ -81,7 +212,7 @@ namespace c0
         <expression> ::=
             <additive-expression>
         */
-        ExprASTPtr AnalyseExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst);
+        ExprASTPtr AnalyseExpr(ASTPtr parent, AnalyseError& err);
 
         /*
         <condition> ::=
@@ -94,25 +225,25 @@ namespace c0
         <additive-expression> ::=
             <multiplicative-expression>{<additive-operator><multiplicative-expression>}
         */
-        ExprASTPtr AnalyseAddExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst);
+        ExprASTPtr AnalyseAddExpr(ASTPtr parent, AnalyseError& err);
 
         /*
         <multiplicative-expression> ::=
             <cast-expression>{<multiplicative-operator><cast-expression>}
         */
-        ExprASTPtr AnalyseMulExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst);
+        ExprASTPtr AnalyseMulExpr(ASTPtr parent, AnalyseError& err);
 
         /*
         <cast-expression> ::=
             {'('<type-specifier>')'}<unary-expression>
         */
-        ExprASTPtr AnalyseCastExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst);
+        ExprASTPtr AnalyseCastExpr(ASTPtr parent, AnalyseError& err);
 
         /*
         <unary-expression> ::=
             [<unary-operator>]<primary-expression>
         */
-        ExprASTPtr AnalyseUnaryExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst);
+        ExprASTPtr AnalyseUnaryExpr(ASTPtr parent, AnalyseError& err);
 
         /*
         <primary-expression> ::=
@@ -123,7 +254,7 @@ namespace c0
             |<floating-literal>
             |<function-call>
         */
-        ExprASTPtr AnalysePrimaryExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst);
+        ExprASTPtr AnalysePrimaryExpr(ASTPtr parent, AnalyseError& err);
 
         /*
         <assignment-expression> ::=
@@ -138,7 +269,7 @@ namespace c0
         <expression-list> ::= 
             <expression>{','<expression>}
         */
-        ExprASTPtr AnalyseFuncCallExpr(ASTPtr parent, AnalyseError& err, bool isNeedReturn);
+        FuncCallExprASTPtr AnalyseFuncCallExpr(ASTPtr parent, AnalyseError& err);
 
         //---------------------------------------------------------------------
 
@@ -149,7 +280,7 @@ namespace c0
             {<statement>}
         
         */
-        BlockStmtASTPtr AnalyseBlockStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue);
+        BlockStmtASTPtr AnalyseBlockStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue);
 
         /*
         <statement> ::= 
@@ -163,14 +294,14 @@ namespace c0
             |<function-call>';'
             |';'
         */
-        StmtASTPtr AnalyseStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue, bool* isSemicolon = nullptr);
+        StmtASTPtr AnalyseStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue, bool* isSemicolon = nullptr);
 
         /*
         <condition-statement> ::=
              'if' '(' <condition> ')' <statement> ['else' <statement>]
             |'switch' '(' <expression> ')' '{' {<labeled-statement>} '}'
         */
-        CondStmtASTPtr AnalyseCondStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue);
+        CondStmtASTPtr AnalyseCondStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue);
 
         /*
         <loop-statement> ::=
@@ -178,7 +309,7 @@ namespace c0
            |'do' <statement> 'while' '(' <condition> ')' ';'
            |'for' '('<for-init-statement> [<condition>]';' [<for-update-expression>]')' <statement>
         */
-        LoopStmtASTPtr AnalyseLoopStmt(ASTPtr parent, AnalyseError& err, VarType retType);
+        LoopStmtASTPtr AnalyseLoopStmt(ASTPtr parent, AnalyseError& err);
 
         /*
         <jump-statement> ::=
@@ -186,7 +317,7 @@ namespace c0
             |'continue' ';'
             |<return-statement>
         */
-        JumpStmtASTPtr AnalyseJumpStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue);
+        JumpStmtASTPtr AnalyseJumpStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue);
 
         /*
         <print-statement> ::= 'print' '(' [<printable-list>] ')' ';'
@@ -221,29 +352,29 @@ namespace c0
         /*
         'if' '(' <condition> ')' <statement> ['else' <statement>]
         */
-        IfStmtASTPtr AnalyseIfStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue);
+        IfStmtASTPtr AnalyseIfStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue);
 
         /*
         'switch' '(' <expression> ')' '{' {<labeled-statement>} '}'
         */
-        SwitchStmtASTPtr AnalyseSwitchStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canContinue);
+        SwitchStmtASTPtr AnalyseSwitchStmt(ASTPtr parent, AnalyseError& err, bool canContinue);
 
         /*
         <labeled-statement> ::= 
              'case' (<integer-literal>|<char-literal>) ':' <statement>
             |'default' ':' <statement>
         */
-        StmtASTPtr AnalyseLabeledStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canContinue);
+        StmtASTPtr AnalyseLabeledStmt(ASTPtr parent, AnalyseError& err, bool canContinue);
 
         /*
         'while' '(' <condition> ')' <statement>
         */
-        WhileStmtASTPtr AnalyseWhileStmt(ASTPtr parent, AnalyseError& err, VarType retType);
+        WhileStmtASTPtr AnalyseWhileStmt(ASTPtr parent, AnalyseError& err);
 
         /*
         'do' <statement> 'while' '(' <condition> ')' ';'
         */
-        DoStmtASTPtr AnalyseDoStmt(ASTPtr parent, AnalyseError& err, VarType retType);
+        DoStmtASTPtr AnalyseDoStmt(ASTPtr parent, AnalyseError& err);
 
         /*
         'for' '('<for-init-statement> [<condition>]';' [<for-update-expression>]')' <statement>
@@ -252,7 +383,7 @@ namespace c0
         <for-update-expression> ::=
             (<assignment-expression>|<function-call>){','(<assignment-expression>|<function-call>)}
         */
-        ForStmtASTPtr AnalyseForStmt(ASTPtr parent, AnalyseError& err, VarType retType);
+        ForStmtASTPtr AnalyseForStmt(ASTPtr parent, AnalyseError& err);
 
         /*
         'break' ';'
@@ -267,15 +398,15 @@ namespace c0
         /*
         <return-statement> ::= 'return' [<expression>] ';'
         */
-        ReturnStmtASTPtr AnalyseReturnStmt(ASTPtr parent, AnalyseError& err, VarType retType);
-
-    private:
-        ExprASTPtr CheckInexplicitTypeCast(ASTPtr parent, AnalyseError& err, const Token& token,
-            ExprASTPtr fromExpr, VarType toType, const str_t& extralog);
+        ReturnStmtASTPtr AnalyseReturnStmt(ASTPtr parent, AnalyseError& err);
 
     private:
         const TokenList _tokens;
         std::size_t _cur = 0;
+        FileASTPtr _file;   // file being analysed, owns the nodes created
+        AnalyseWarningList _warnings;
+        std::vector<std::function<void()>> _undos;      // changes to file by Reanalyse, undone in reverse
+        std::vector<const AST*> _replaced;              // bodies and initializers replaced by Reanalyse
     };
 }
 
@@ -1,33 +1,299 @@
 #include "all_ast.h"
+#ifndef C0_NO_AST_INSTANCE_COUNT
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <mutex>
+#endif
 
 namespace c0
 {
-    std::atomic<std::int32_t> _astInstanceCount = {0};
-    instancemap_t _astInstanceMap;
+#ifndef C0_NO_AST_INSTANCE_COUNT
+    namespace
+    {
+        constexpr std::size_t ASTTypeCount = std::size_t(ASTType::File) + 1;
+        using counters_t = std::array<std::atomic<std::int32_t>, ASTTypeCount>;
+
+        // counters of threads alive, and the sum of counters of threads exited
+        struct InstanceRegistry
+        {
+            std::mutex mutex;
+            std::vector<const counters_t*> threads;
+            std::array<std::int32_t, ASTTypeCount> exited = {};
+        };
+
+        InstanceRegistry& GetInstanceRegistry()
+        {
+            // never destroyed, threads may exit after static destruction
+            static auto registry = new InstanceRegistry();
+            return *registry;
+        }
+
+        /*
+        counters are written by the owner thread only, so a plain load and
+        store is enough, other threads read them when aggregating. a node
+        destroyed by another thread than the one created it makes a counter
+        negative, the sum is still right.
+        */
+        class ThreadInstanceCounters
+        {
+        public:
+            ThreadInstanceCounters()
+            {
+                for (auto& count : _counts)
+                    count.store(0, std::memory_order_relaxed);
+
+                auto& registry = GetInstanceRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.threads.push_back(&_counts);
+            }
+            ~ThreadInstanceCounters()
+            {
+                auto& registry = GetInstanceRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                for (std::size_t i = 0; i < ASTTypeCount; ++i)
+                    registry.exited[i] += _counts[i].load(std::memory_order_relaxed);
+                registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), &_counts));
+            }
+
+            void Add(ASTType type, std::int32_t n)
+            {
+                auto& count = _counts[std::size_t(type)];
+                count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+
+        private:
+            counters_t _counts;
+        };
+
+        thread_local ThreadInstanceCounters _astInstanceCounters;
+
+        std::array<std::int32_t, ASTTypeCount> SumInstanceCounters()
+        {
+            auto& registry = GetInstanceRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            auto sum = registry.exited;
+            for (auto counts : registry.threads)
+            {
+                for (std::size_t i = 0; i < ASTTypeCount; ++i)
+                    sum[i] += (*counts)[i].load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+    }
+
+    int32_t AST::GetInstanceCount()
+    {
+        std::int32_t count = 0;
+        for (auto n : SumInstanceCounters())
+            count += n;
+        return count;
+    }
+
+    instancemap_t AST::GetInstanceMap()
+    {
+        instancemap_t map;
+        const auto sum = SumInstanceCounters();
+        for (std::size_t i = 0; i < ASTTypeCount; ++i)
+        {
+            if (sum[i] != 0)
+                map[ASTType(i)] = sum[i];
+        }
+        return map;
+    }
+
+    AST::AST(ASTPtr parent, ASTType type)
+        : _parent(parent)
+        , _id(0)
+        , _type(static_cast<std::uint32_t>(type))
+    {
+        _astInstanceCounters.Add(GetASTType(), 1);
+    }
 
+    AST::~AST()
+    {
+        _astInstanceCounters.Add(GetASTType(), -1);
+    }
+#else
     int32_t AST::GetInstanceCount()
     {
-        return _astInstanceCount.load(std::memory_order::memory_order_acquire);
+        return 0;
     }
 
-    const instancemap_t& AST::GetInstanceMap()
+    instancemap_t AST::GetInstanceMap()
     {
-        return _astInstanceMap;
+        return instancemap_t();
     }
 
     AST::AST(ASTPtr parent, ASTType type)
         : _parent(parent)
-        , _type(type)
+        , _id(0)
+        , _type(static_cast<std::uint32_t>(type))
     {
-        ++_astInstanceMap[_type];
-        _astInstanceCount.fetch_add(1, std::memory_order::memory_order_release);
     }
 
     AST::~AST()
     {
-        _astInstanceCount.fetch_sub(1, std::memory_order::memory_order_release);
-        --_astInstanceMap[_type];
+    }
+#endif
+
+    ASTContext::~ASTContext()
+    {
+        Destroy({ 0, 0, 0 });
+    }
+
+    void ASTContext::Rewind(const Mark& mark)
+    {
+        CheckNotFrozen();
+        Destroy(mark);
+    }
+
+    void ASTContext::Destroy(const Mark& mark)
+    {
+        for (auto i = _nodes.size(); i > mark.node; --i)
+            _nodes[i - 1]->~AST();
+        _nodes.resize(mark.node);
+        _deadNodeCount = std::min(_deadNodeCount, mark.node);
+
+        for (auto it = _userdata.begin(); it != _userdata.end();)
+        {
+            if (it->first > mark.node)
+                it = _userdata.erase(it);
+            else
+                ++it;
+        }
+
+        // blocks are kept for reuse
+        _block = mark.block;
+        _used = mark.used;
+    }
+
+    std::size_t ASTContext::GetMemorySize() const
+    {
+        return _blocks.size() * BlockSize + _nodes.capacity() * sizeof(AST*);
+    }
+
+    ASTUserDataPtr ASTContext::GetUserData(const AST& ast) const
+    {
+        const auto it = _userdata.find(static_cast<std::uint32_t>(ast.GetId()));
+        if (it == _userdata.end())
+            return nullptr;
+        return it->second;
+    }
+
+    void ASTContext::SetUserData(const AST& ast, ASTUserDataPtr ptr)
+    {
+        CheckNotFrozen();
+        const auto id = static_cast<std::uint32_t>(ast.GetId());
+        if (nullptr == ptr)
+            _userdata.erase(id);
+        else
+            _userdata[id] = std::move(ptr);
+    }
+
+    void* ASTContext::Allocate(std::size_t size, std::size_t align)
+    {
+        if (_blocks.empty())
+            _blocks.emplace_back(new char[BlockSize]);
+
+        auto offset = (_used + align - 1) / align * align;
+        if (offset + size > BlockSize)
+        {
+            if (++_block == _blocks.size())
+                _blocks.emplace_back(new char[BlockSize]);
+            offset = 0;
+        }
+        _used = offset + size;
+        return _blocks[_block].get() + offset;
+    }
+
+    bool AST::FindInSymbolTable(const SymbolTable* symbols, const str_t& s, bool recusive, DeclASTPtr& decl) const
+    {
+        if (nullptr == symbols)
+            return false;
+        const auto scope = symbols->GetScope(*this);
+        if (SymbolTable::NoScope == scope)
+            return false;
+        decl = symbols->Find(scope, s, recusive);
+        return true;
+    }
+
+    SymbolType AST::GetDeclSymbolType(DeclASTPtr decl)
+    {
+        if (nullptr == decl)
+            return SymbolType::Nul;
+        switch (decl->GetDeclType())
+        {
+        case DeclType::Func: return SymbolType::Func;
+        case DeclType::ConstVar: return SymbolType::ConstVar;
+        default: return SymbolType::Var;
+        }
+    }
+
+    const std::size_t SymbolTable::NoScope;
+
+    void SymbolTable::Clear()
+    {
+        _scopes.clear();
+        _owners.clear();
+        _current = NoScope;
+        _deadScopeCount = 0;
+    }
+
+    std::size_t SymbolTable::EnterScope(const AST& owner)
+    {
+        // a scope entered again for the same owner replaces the old one, which is left unreachable
+        _scopes.push_back({ &owner, _current, {} });
+        _current = _scopes.size() - 1;
+        _owners[&owner] = _current;
+        return _current;
+    }
+
+    void SymbolTable::LeaveScope()
+    {
+        _current = _scopes[_current].parent;
+    }
+
+    std::size_t SymbolTable::GetScope(const AST& owner) const
+    {
+        const auto it = _owners.find(&owner);
+        if (it == _owners.end())
+            return NoScope;
+        return it->second;
+    }
+
+    bool SymbolTable::Declare(const str_t& name, DeclASTPtr decl)
+    {
+        return _scopes[_current].symbols.emplace(name, decl).second;
+    }
+
+    DeclASTPtr SymbolTable::Find(std::size_t scope, const str_t& name, bool recursive) const
+    {
+        while (NoScope != scope)
+        {
+            const auto& symbols = _scopes[scope].symbols;
+            const auto it = symbols.find(name);
+            if (it != symbols.end())
+                return it->second;
+            if (!recursive)
+                break;
+            scope = _scopes[scope].parent;
+        }
+        return nullptr;
+    }
+
+    void SymbolTable::Rewind(std::size_t mark)
+    {
+        for (auto i = _scopes.size(); i > mark; --i)
+        {
+            const auto it = _owners.find(_scopes[i - 1].owner);
+            if (it != _owners.end() && it->second == i - 1)
+                _owners.erase(it);
+        }
+        // parents are entered before their children
+        while (NoScope != _current && _current >= mark)
+            _current = _scopes[_current].parent;
+        _scopes.resize(mark);
     }
 
     bool FileAST::Accept(ASTVisitor& visitor) const
@@ -55,6 +321,9 @@ namespace c0
 
     SymbolType FileAST::GetSymbolType(const str_t& s, bool recusive) const
     {
+        DeclASTPtr decl = nullptr;
+        if (FindInSymbolTable(&_symbols, s, recusive, decl))
+            return GetDeclSymbolType(decl);
         GET_SYMBOLTYPE_HELPER(_vars);
         for (const auto& func : _funcs)
         {
@@ -66,6 +335,9 @@ namespace c0
 
     ASTPtr FileAST::GetSymbol(const str_t& s, bool recusive) const
     {
+        DeclASTPtr decl = nullptr;
+        if (FindInSymbolTable(&_symbols, s, recusive, decl))
+            return decl;
         GET_SYMBOL_HELPER(_vars);
         for (const auto& func : _funcs)
         {
@@ -86,26 +358,6 @@ namespace c0
         }
         return VarType::Nul;
     }
-
-    VarType MergeVarType(VarType a, VarType b)
-    {
-        if (VarType::Float == a || VarType::Float == b)
-            return VarType::Float;
-        if (VarType::Void == a || VarType::Void == b)
-            return a == b ? VarType::Void : VarType::Nul;
-        return VarType::Int;
-    }
-
-    bool IsValidCastType(VarType t)
-    {
-        return t >= VarType::Int && t <= VarType::Float;
-    }
-
-    bool IsVarTypeCastable(VarType from, VarType to)
-    {
-        return from >= VarType::Int && from <= VarType::Float
-            && to >= VarType::Int && to <= VarType::Float;
-    }
 }
 
 namespace std
@@ -1,7 +1,11 @@
 #pragma once
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 #include <map>
+#include "small_vector.h"
 #include "token.h"
 
 namespace c0
@@ -14,7 +18,7 @@ namespace c0
         Func,
     };
 
-    enum class BinaryType
+    enum class BinaryType : std::uint8_t
     {
         Nul,
         Add,            // +
@@ -29,7 +33,7 @@ namespace c0
         GreaterEqual,   // >=
     };
 
-    enum class UnaryType
+    enum class UnaryType : std::uint8_t
     {
         Nul,
         Positive,
@@ -44,7 +48,7 @@ namespace c0
         Func,
     };
 
-    enum class VarType
+    enum class VarType : std::uint8_t
     {
         Nul,
         Void,
@@ -97,10 +101,11 @@ namespace c0
         File,
     };
 
+    // child lists keep up to two nodes inline, most of them never allocate
 #define AST_DECL_HELPER(name) \
     class name; \
-    using name##Ptr = std::shared_ptr<name>; \
-    using name##PtrList = std::vector<name##Ptr>
+    using name##Ptr = name*; \
+    using name##PtrList = SmallVector<name##Ptr, 2>
 
     AST_DECL_HELPER(AST);
 
@@ -147,10 +152,15 @@ namespace c0
     AST_DECL_HELPER(VarDeclAST);
     AST_DECL_HELPER(FuncDeclAST);
 
-    AST_DECL_HELPER(FileAST);
-
 #undef AST_DECL_HELPER
 
+    class SymbolTable;
+
+    // file is the only node not allocated in ASTContext, it owns the context
+    class FileAST;
+    using FileASTPtr = std::shared_ptr<FileAST>;
+    using ConstFileASTPtr = std::shared_ptr<const FileAST>;
+
 #define VISIT_AST_HELPER(name)                      \
     for (const auto& ptr : name)                    \
     {                                               \
@@ -192,17 +202,22 @@ namespace c0
 
     using instancemap_t = std::map<ASTType, std::int32_t>;
 
-    class AST : public std::enable_shared_from_this<AST>
+    class AST
     {
     public:
+        // live nodes of all threads, always 0 if built with C0_NO_AST_INSTANCE_COUNT
         static int32_t GetInstanceCount();
-        static const instancemap_t& GetInstanceMap();
+        static instancemap_t GetInstanceMap();
 
     public:
         AST(ASTPtr parent, ASTType type);
         virtual ~AST();
 
-        ASTType GetASTType() const { return _type; }
+        ASTType GetASTType() const { return ASTType(_type); }
+        // index of node in its ASTContext counted from 1, 0 for node not created by a context
+        std::size_t GetId() const { return _id; }
+        std::size_t GetTokenIndex() const { return _token; }
+        void SetTokenIndex(std::size_t token) { _token = static_cast<std::uint32_t>(token); }
         virtual std::string ToString() const = 0;
         virtual bool Accept(ASTVisitor& visitor) const = 0;
 
@@ -215,12 +230,18 @@ namespace c0
             return DefaultGetSymbolImpl(s, recusive);
         }
 
-        ASTPtr GetParent() const { return _parent.lock(); }
+        ASTPtr GetParent() const { return _parent; }
         void SetParent(ASTPtr parent) { _parent = parent; }
-        const ASTUserDataPtr& GetUserData() const { return _userdata; }
-        void SetUserData(ASTUserDataPtr ptr) const { _userdata = ptr; }
 
     protected:
+        /*
+        lookup in the symbol table built by semantic analyse for the scope
+        owned by this node, false if there is none and the caller scans.
+        symbols is kept by the scope owner, nothing is climbed to reach it.
+        */
+        bool FindInSymbolTable(const SymbolTable* symbols, const str_t& s, bool recusive, DeclASTPtr& decl) const;
+        static SymbolType GetDeclSymbolType(DeclASTPtr decl);
+
         SymbolType DefaultGetSymbolTypeImpl(const str_t& s, bool recusive) const
         {
             if (recusive)
@@ -243,11 +264,152 @@ namespace c0
         }
 
     private:
-        std::weak_ptr<AST> _parent;
-        ASTType _type;
-        mutable ASTUserDataPtr _userdata;
+        friend class ASTContext;
+
+        // 16 bytes after the vtable pointer, node type data follows
+        AST* _parent;
+        std::uint32_t _token = 0;   // index of the token this node is anchored to
+        std::uint32_t _id : 24;
+        std::uint32_t _type : 8;    // ASTType
+    };
+
+    /*
+    arena of ast nodes: nodes are placement constructed in large blocks and
+    destroyed together with the context in reverse order of creation, nodes
+    created after a mark can be destroyed early by rewinding to the mark.
+    a node never destroys its children, so teardown is one loop over the
+    nodes whatever the depth of the tree. each node gets the next id, user
+    data of nodes are kept in a side table keyed by id instead of in the
+    nodes. nodes unlinked from the tree, e.g. a function body replaced by
+    Reanalyse, are only destroyed with the context and counted as dead.
+    */
+    class ASTContext
+    {
+    public:
+        struct Mark
+        {
+            std::size_t node;   // number of nodes
+            std::size_t block;  // index of current block
+            std::size_t used;   // bytes used in current block
+        };
+
+    public:
+        ASTContext() = default;
+        ASTContext(const ASTContext&) = delete;
+        ASTContext& operator=(const ASTContext&) = delete;
+        ~ASTContext();
+
+        template<typename T, typename... Args>
+        T* New(Args&&... args)
+        {
+            CheckNotFrozen();
+            if (_nodes.size() >= MaxNodeCount)
+                throw std::length_error("too many ast nodes in one context");
+
+            auto ast = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            _nodes.push_back(ast);
+            ast->_id = static_cast<std::uint32_t>(_nodes.size());
+            return ast;
+        }
+
+        Mark GetMark() const { return { _nodes.size(), _block, _used }; }
+        void Rewind(const Mark& mark);
+
+        std::size_t GetNodeCount() const { return _nodes.size(); }
+        std::size_t GetDeadNodeCount() const { return _deadNodeCount; }
+        void AddDeadNodes(std::size_t count) { _deadNodeCount += count; }
+        AST* GetNode(std::size_t id) const { return _nodes[id - 1]; }
+        std::size_t GetMemorySize() const;
+
+        // for nodes of this context, and its owner with id 0
+        ASTUserDataPtr GetUserData(const AST& ast) const;
+        void SetUserData(const AST& ast, ASTUserDataPtr ptr);
+
+        // no node is created, destroyed or given user data after freeze
+        void Freeze() { _isFrozen = true; }
+        bool IsFrozen() const { return _isFrozen; }
+        void CheckNotFrozen() const
+        {
+            if (_isFrozen)
+                throw std::logic_error("ast is frozen");
+        }
+
+    private:
+        void* Allocate(std::size_t size, std::size_t align);
+        void Destroy(const Mark& mark);
+
+    private:
+        static const std::size_t BlockSize = 64 * 1024;
+        static const std::size_t MaxNodeCount = (1 << 24) - 1;
+
+        std::vector<std::unique_ptr<char[]>> _blocks;
+        std::size_t _block = 0;
+        std::size_t _used = 0;
+        std::vector<AST*> _nodes;
+        std::size_t _deadNodeCount = 0;
+        std::unordered_map<std::uint32_t, ASTUserDataPtr> _userdata;
+        bool _isFrozen = false;
     };
 
+    /*
+    scoped symbol table built by semantic analyse, with one hash map of names
+    per scope. scopes are owned by the file, functions (name and parameters)
+    and blocks, and linked to their enclosing scope, so a lookup costs one
+    probe per enclosing scope. the file keeps the table for later passes.
+    the scopes of a function body replaced by Reanalyse are left unreachable
+    and counted as dead until the table is cleared.
+    */
+    class SymbolTable
+    {
+    public:
+        static const std::size_t NoScope = static_cast<std::size_t>(-1);
+
+        void Clear();
+
+        // scope of owner is started empty as child of the current scope and becomes current
+        std::size_t EnterScope(const AST& owner);
+        void LeaveScope();
+        std::size_t GetCurrentScope() const { return _current; }
+        void SetCurrentScope(std::size_t scope) { _current = scope; }
+        std::size_t GetScope(const AST& owner) const;
+        std::size_t GetScopeCount() const { return _scopes.size(); }
+        std::size_t GetDeadScopeCount() const { return _deadScopeCount; }
+        void AddDeadScopes(std::size_t count) { _deadScopeCount += count; }
+
+        // false if name is declared in the current scope already
+        bool Declare(const str_t& name, DeclASTPtr decl);
+        DeclASTPtr Find(const str_t& name) const { return Find(_current, name, true); }
+        DeclASTPtr Find(std::size_t scope, const str_t& name, bool recursive) const;
+
+        // scopes entered after mark are dropped
+        std::size_t GetMark() const { return _scopes.size(); }
+        void Rewind(std::size_t mark);
+
+    private:
+        struct Scope
+        {
+            const AST* owner;
+            std::size_t parent;
+            std::unordered_map<str_t, DeclASTPtr> symbols;
+        };
+
+        std::vector<Scope> _scopes;
+        std::unordered_map<const AST*, std::size_t> _owners;
+        std::size_t _current = NoScope;
+        std::size_t _deadScopeCount = 0;
+    };
+
+    /*
+    a file can be frozen when analyse is done, the tree is not changed any
+    more: its context refuses new nodes, AddVar/AddFunc throw, and Reanalyse
+    builds a new file instead of splicing into it. setters of the nodes are
+    not checked, passes must only use const member functions.
+
+    all const queries of a frozen tree are safe to call from several threads
+    at once: GetParent, GetSymbol, GetSymbolType, GetVarType, ToString,
+    Accept with a visitor per thread, StaticASTVisitor, FlatAST, ASTAttribute
+    owned by one thread, and ASTContext::GetUserData.
+    */
     class FileAST : public AST
     {
     public:
@@ -258,21 +420,78 @@ namespace c0
         SymbolType GetSymbolType(const str_t& s, bool recusive) const override;
         ASTPtr GetSymbol(const str_t& s, bool recusive) const override;
 
-        void AddVar(VarDeclASTPtr ptr) { _vars.push_back(ptr); }
-        void AddFunc(FuncDeclASTPtr ptr) { _funcs.push_back(ptr); }
+        void AddVar(VarDeclASTPtr ptr) { _context.CheckNotFrozen(); _vars.push_back(ptr); }
+        void AddFunc(FuncDeclASTPtr ptr) { _context.CheckNotFrozen(); _funcs.push_back(ptr); }
 
         const VarDeclASTPtrList& GetVars() const { return _vars; }
-        const FuncDeclASTPtrList GetFuncs() const { return _funcs; }
+        const FuncDeclASTPtrList& GetFuncs() const { return _funcs; }
+
+        ASTContext& GetContext() { return _context; }
+        const ASTContext& GetContext() const { return _context; }
+
+        void Freeze() { _context.Freeze(); }
+        bool IsFrozen() const { return _context.IsFrozen(); }
+
+        SymbolTable& GetSymbolTable() { return _symbols; }
+        const SymbolTable& GetSymbolTable() const { return _symbols; }
 
     private:
+        ASTContext _context;    // destroyed last, after the node lists
+        SymbolTable _symbols;
         VarDeclASTPtrList _vars;
         FuncDeclASTPtrList _funcs;
     };
 
     VarType TokenType2VarType(TokenType type);
-    VarType MergeVarType(VarType a, VarType b);
-    bool IsValidCastType(VarType t);
-    bool IsVarTypeCastable(VarType from, VarType to);
+
+    /*
+    implicit conversions of c0 as tables indexed by VarType, row is the
+    first operand or the source type. arithmetic of two operands is done in
+    the merged type: double if either is double, int otherwise, void only
+    with void. int, char and double convert to each other, a merged type an
+    operand cannot convert to, e.g. of a string, is a type error.
+    */
+    namespace var_type_table
+    {
+        constexpr std::size_t Count = 6;
+
+        constexpr VarType Merge[Count][Count] = {
+            //  Nul             Void            Int             Char            Float           Str
+            { VarType::Int,   VarType::Nul,   VarType::Int,   VarType::Int,   VarType::Float, VarType::Int },    // Nul
+            { VarType::Nul,   VarType::Void,  VarType::Nul,   VarType::Nul,   VarType::Float, VarType::Nul },    // Void
+            { VarType::Int,   VarType::Nul,   VarType::Int,   VarType::Int,   VarType::Float, VarType::Int },    // Int
+            { VarType::Int,   VarType::Nul,   VarType::Int,   VarType::Int,   VarType::Float, VarType::Int },    // Char
+            { VarType::Float, VarType::Float, VarType::Float, VarType::Float, VarType::Float, VarType::Float },    // Float
+            { VarType::Int,   VarType::Nul,   VarType::Int,   VarType::Int,   VarType::Float, VarType::Int },    // Str
+        };
+
+        constexpr bool Cast[Count][Count] = {
+            //  Nul     Void    Int     Char    Float   Str
+            { false,  false,  false,  false,  false,  false },    // Nul
+            { false,  false,  false,  false,  false,  false },    // Void
+            { false,  false,  true,   true,   true,   false },    // Int
+            { false,  false,  true,   true,   true,   false },    // Char
+            { false,  false,  true,   true,   true,   false },    // Float
+            { false,  false,  false,  false,  false,  false },    // Str
+        };
+    }
+
+    constexpr VarType MergeVarType(VarType a, VarType b)
+    {
+        return var_type_table::Merge[static_cast<std::size_t>(a)][static_cast<std::size_t>(b)];
+    }
+    constexpr bool IsValidCastType(VarType t)
+    {
+        return var_type_table::Cast[static_cast<std::size_t>(t)][static_cast<std::size_t>(t)];
+    }
+    constexpr bool IsVarTypeCastable(VarType from, VarType to)
+    {
+        return var_type_table::Cast[static_cast<std::size_t>(from)][static_cast<std::size_t>(to)];
+    }
+
+    static_assert(static_cast<std::size_t>(VarType::Str) + 1 == var_type_table::Count, "a row for each VarType");
+    static_assert(MergeVarType(VarType::Char, VarType::Char) == VarType::Int, "char arithmetic is done in int");
+    static_assert(IsVarTypeCastable(VarType::Float, VarType::Char) && !IsValidCastType(VarType::Void), "void has no value to cast");
 }
 
 namespace std
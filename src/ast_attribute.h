@@ -0,0 +1,52 @@
+#pragma once
+#include "ast.h"
+#include <type_traits>
+
+namespace c0
+{
+    /*
+    typed value attached to every node of one file by a pass, stored densely
+    and indexed by node id, with no allocation or reference count per node.
+    the attribute belongs to the pass instead of the tree, so passes each
+    with their own attributes can run concurrently over one tree, e.g.
+
+        ASTAttribute<VarType> types(*file, VarType::Nul);
+        types[*expr] = VarType::Int;
+
+    the file itself has id 0, nodes created after the attribute are given
+    the default value on first write.
+    */
+    template<typename T>
+    class ASTAttribute
+    {
+        static_assert(!std::is_same<T, bool>::value,
+            "ASTAttribute<bool> would pack bits, concurrent writes to different nodes would race, use char");
+
+    public:
+        ASTAttribute() = default;
+        explicit ASTAttribute(const FileAST& file, const T& value = T())
+            : _values(file.GetContext().GetNodeCount() + 1, value)
+            , _default(value)
+        {}
+
+        const T& operator[](const AST& ast) const
+        {
+            const auto id = ast.GetId();
+            return id < _values.size() ? _values[id] : _default;
+        }
+        T& operator[](const AST& ast)
+        {
+            const auto id = ast.GetId();
+            if (id >= _values.size())
+                _values.resize(id + 1, _default);
+            return _values[id];
+        }
+
+        std::size_t GetSize() const { return _values.size(); }
+        void Clear() { _values.assign(_values.size(), _default); }
+
+    private:
+        std::vector<T> _values;
+        T _default = T();
+    };
+}
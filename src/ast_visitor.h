@@ -0,0 +1,191 @@
+#pragma once
+#include "all_ast.h"
+
+namespace c0
+{
+    /*
+    visitor dispatched once per node on its ASTType with static_cast, without
+    virtual call or dynamic_cast. Derived hides Visit##name for the node types
+    it handles, every other node visits its children, e.g.
+
+        class IntExprCounter : public StaticASTVisitor<IntExprCounter>
+        {
+        public:
+            void VisitIntExpr(const IntExprAST&) { ++count; }
+            std::size_t count = 0;
+        };
+
+        IntExprCounter counter;
+        counter.Visit(*file);
+
+    a Visit##name of Derived calls VisitChildren(ast) to go on into the subtree,
+    Derived may also hide Visit(const AST&) to act on every node before
+    dispatching. children are visited in the order of the members of the node,
+    the virtual ASTVisitor interface can still be used on the same ast.
+    */
+    template<typename Derived>
+    class StaticASTVisitor
+    {
+    public:
+        void Visit(const AST& ast)
+        {
+#define STATIC_VISIT_HELPER(name) \
+    case ASTType::name: Self().Visit##name(static_cast<const name##AST&>(ast)); break
+
+            switch (ast.GetASTType())
+            {
+                STATIC_VISIT_HELPER(BinaryExpr);
+                STATIC_VISIT_HELPER(CastExpr);
+                STATIC_VISIT_HELPER(UnaryExpr);
+                STATIC_VISIT_HELPER(BraceExpr);
+                STATIC_VISIT_HELPER(IdentExpr);
+                STATIC_VISIT_HELPER(IntExpr);
+                STATIC_VISIT_HELPER(CharExpr);
+                STATIC_VISIT_HELPER(FloatExpr);
+                STATIC_VISIT_HELPER(StrExpr);
+                STATIC_VISIT_HELPER(AssignExpr);
+                STATIC_VISIT_HELPER(FuncCallExpr);
+                STATIC_VISIT_HELPER(EmptyStmt);
+                STATIC_VISIT_HELPER(BlockStmt);
+                STATIC_VISIT_HELPER(PrintStmt);
+                STATIC_VISIT_HELPER(ScanStmt);
+                STATIC_VISIT_HELPER(AssignStmt);
+                STATIC_VISIT_HELPER(FuncCallStmt);
+                STATIC_VISIT_HELPER(IfStmt);
+                STATIC_VISIT_HELPER(SwitchStmt);
+                STATIC_VISIT_HELPER(LabeledStmt);
+                STATIC_VISIT_HELPER(WhileStmt);
+                STATIC_VISIT_HELPER(DoStmt);
+                STATIC_VISIT_HELPER(ForStmt);
+                STATIC_VISIT_HELPER(BreakStmt);
+                STATIC_VISIT_HELPER(ContinueStmt);
+                STATIC_VISIT_HELPER(ReturnStmt);
+                STATIC_VISIT_HELPER(VarDecl);
+                STATIC_VISIT_HELPER(FuncDecl);
+            case ASTType::File: Self().VisitFile(static_cast<const FileAST&>(ast)); break;
+            default: break;
+            }
+
+#undef STATIC_VISIT_HELPER
+        }
+
+        void VisitBinaryExpr(const BinaryExprAST& ast) { VisitChildren(ast); }
+        void VisitCastExpr(const CastExprAST& ast) { VisitChildren(ast); }
+        void VisitUnaryExpr(const UnaryExprAST& ast) { VisitChildren(ast); }
+        void VisitBraceExpr(const BraceExprAST& ast) { VisitChildren(ast); }
+        void VisitIdentExpr(const IdentExprAST&) {}
+        void VisitIntExpr(const IntExprAST&) {}
+        void VisitCharExpr(const CharExprAST&) {}
+        void VisitFloatExpr(const FloatExprAST&) {}
+        void VisitStrExpr(const StrExprAST&) {}
+        void VisitAssignExpr(const AssignExprAST& ast) { VisitChildren(ast); }
+        void VisitFuncCallExpr(const FuncCallExprAST& ast) { VisitChildren(ast); }
+
+        void VisitEmptyStmt(const EmptyStmtAST&) {}
+        void VisitBlockStmt(const BlockStmtAST& ast) { VisitChildren(ast); }
+        void VisitPrintStmt(const PrintStmtAST& ast) { VisitChildren(ast); }
+        void VisitScanStmt(const ScanStmtAST&) {}
+        void VisitAssignStmt(const AssignStmtAST& ast) { VisitChildren(ast); }
+        void VisitFuncCallStmt(const FuncCallStmtAST& ast) { VisitChildren(ast); }
+        void VisitIfStmt(const IfStmtAST& ast) { VisitChildren(ast); }
+        void VisitSwitchStmt(const SwitchStmtAST& ast) { VisitChildren(ast); }
+        void VisitLabeledStmt(const LabeledStmtAST& ast) { VisitChildren(ast); }
+        void VisitWhileStmt(const WhileStmtAST& ast) { VisitChildren(ast); }
+        void VisitDoStmt(const DoStmtAST& ast) { VisitChildren(ast); }
+        void VisitForStmt(const ForStmtAST& ast) { VisitChildren(ast); }
+        void VisitBreakStmt(const BreakStmtAST&) {}
+        void VisitContinueStmt(const ContinueStmtAST&) {}
+        void VisitReturnStmt(const ReturnStmtAST& ast) { VisitChildren(ast); }
+
+        void VisitVarDecl(const VarDeclAST& ast) { VisitChildren(ast); }
+        void VisitFuncDecl(const FuncDeclAST& ast) { VisitChildren(ast); }
+        void VisitFile(const FileAST& ast) { VisitChildren(ast); }
+
+    protected:
+        void VisitChildren(const BinaryExprAST& ast)
+        {
+            Self().Visit(*ast.GetLeftExpr());
+            Self().Visit(*ast.GetRightExpr());
+        }
+        void VisitChildren(const CastExprAST& ast) { Self().Visit(*ast.GetExpr()); }
+        void VisitChildren(const UnaryExprAST& ast) { Self().Visit(*ast.GetExpr()); }
+        void VisitChildren(const BraceExprAST& ast) { Self().Visit(*ast.GetExpr()); }
+        void VisitChildren(const AssignExprAST& ast) { Self().Visit(*ast.GetExpr()); }
+        void VisitChildren(const FuncCallExprAST& ast) { VisitList(ast.GetParams()); }
+
+        void VisitChildren(const BlockStmtAST& ast)
+        {
+            VisitList(ast.GetVars());
+            VisitList(ast.GetStmts());
+        }
+        void VisitChildren(const PrintStmtAST& ast) { VisitList(ast.GetParams()); }
+        void VisitChildren(const AssignStmtAST& ast) { Self().Visit(*ast.GetExpr()); }
+        void VisitChildren(const FuncCallStmtAST& ast) { VisitList(ast.GetParams()); }
+        void VisitChildren(const IfStmtAST& ast)
+        {
+            Self().Visit(*ast.GetIfCond());
+            Self().Visit(*ast.GetIFStmt());
+            if (nullptr != ast.GetElseStmt())
+                Self().Visit(*ast.GetElseStmt());
+        }
+        void VisitChildren(const SwitchStmtAST& ast)
+        {
+            Self().Visit(*ast.GetExpr());
+            VisitList(ast.GetStmts());
+        }
+        void VisitChildren(const LabeledStmtAST& ast)
+        {
+            if (nullptr != ast.GetStmt())
+                Self().Visit(*ast.GetStmt());
+        }
+        void VisitChildren(const WhileStmtAST& ast)
+        {
+            Self().Visit(*ast.GetCond());
+            Self().Visit(*ast.GetStmt());
+        }
+        void VisitChildren(const DoStmtAST& ast)
+        {
+            Self().Visit(*ast.GetStmt());
+            Self().Visit(*ast.GetCond());
+        }
+        void VisitChildren(const ForStmtAST& ast)
+        {
+            VisitList(ast.GetInitExprs());
+            Self().Visit(*ast.GetCond());
+            VisitList(ast.GetUpdateExprs());
+            Self().Visit(*ast.GetBody());
+        }
+        void VisitChildren(const ReturnStmtAST& ast)
+        {
+            if (nullptr != ast.GetExpr())
+                Self().Visit(*ast.GetExpr());
+        }
+
+        void VisitChildren(const VarDeclAST& ast)
+        {
+            if (ast.HasExpr())
+                Self().Visit(*ast.GetExpr());
+        }
+        void VisitChildren(const FuncDeclAST& ast)
+        {
+            VisitList(ast.GetParams());
+            if (nullptr != ast.GetBlockStmt())
+                Self().Visit(*ast.GetBlockStmt());
+        }
+        void VisitChildren(const FileAST& ast)
+        {
+            VisitList(ast.GetVars());
+            VisitList(ast.GetFuncs());
+        }
+
+    private:
+        Derived& Self() { return static_cast<Derived&>(*this); }
+
+        template<typename List>
+        void VisitList(const List& list)
+        {
+            for (const auto& ptr : list)
+                Self().Visit(*ptr);
+        }
+    };
+}
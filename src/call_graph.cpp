@@ -0,0 +1,249 @@
+#include "call_graph.h"
+#include "ast_visitor.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace c0
+{
+    namespace
+    {
+        // names of the functions called in a function body
+        class CallCollector : public StaticASTVisitor<CallCollector>
+        {
+        public:
+            void VisitFuncCallExpr(const FuncCallExprAST& ast)
+            {
+                names.push_back(&ast.GetName());
+                VisitChildren(ast);
+            }
+            void VisitFuncCallStmt(const FuncCallStmtAST& ast)
+            {
+                names.push_back(&ast.GetName());
+                VisitChildren(ast);
+            }
+
+            std::vector<const str_t*> names;
+        };
+
+        const std::uint32_t Unvisited = static_cast<std::uint32_t>(-1);
+
+        // edges of a graph reversed with a counting sort
+        void Transpose(const std::vector<std::uint32_t>& offsets, const std::vector<std::uint32_t>& targets,
+            std::vector<std::uint32_t>& transOffsets, std::vector<std::uint32_t>& transTargets)
+        {
+            const auto N = offsets.size() - 1;
+            transOffsets.assign(N + 1, 0);
+            for (const auto target : targets)
+                ++transOffsets[target + 1];
+            for (std::size_t i = 1; i <= N; ++i)
+                transOffsets[i] += transOffsets[i - 1];
+
+            // sources are visited in order, so every list is sorted
+            transTargets.resize(targets.size());
+            auto next = transOffsets;
+            for (std::uint32_t source = 0; source < N; ++source)
+            {
+                for (auto i = offsets[source]; i < offsets[source + 1]; ++i)
+                    transTargets[next[targets[i]]++] = source;
+            }
+        }
+    }
+
+    CallGraph::CallGraph(const FileAST& file)
+    {
+        const auto& funcs = file.GetFuncs();
+        std::unordered_map<str_t, std::uint32_t> index;
+        _names.reserve(funcs.size());
+        for (const auto& func : funcs)
+        {
+            index.emplace(func->GetName(), static_cast<std::uint32_t>(_names.size()));
+            _names.push_back(func->GetName());
+        }
+
+        _calleeOffsets.reserve(funcs.size() + 1);
+        for (const auto& func : funcs)
+        {
+            const auto beg = _callees.size();
+            if (nullptr != func->GetBlockStmt())
+            {
+                CallCollector collector;
+                collector.Visit(*func->GetBlockStmt());
+                for (const auto name : collector.names)
+                {
+                    const auto it = index.find(*name);
+                    if (it != index.end())
+                        _callees.push_back(it->second);
+                }
+            }
+            std::sort(_callees.begin() + beg, _callees.end());
+            _callees.erase(std::unique(_callees.begin() + beg, _callees.end()), _callees.end());
+            _calleeOffsets.push_back(static_cast<std::uint32_t>(_callees.size()));
+        }
+
+        Transpose(_calleeOffsets, _callees, _callerOffsets, _callers);
+        BuildSCCs();
+    }
+
+    bool CallGraph::IsCalling(std::size_t func, std::size_t callee) const
+    {
+        const auto beg = _callees.begin() + _calleeOffsets[func];
+        const auto end = _callees.begin() + _calleeOffsets[func + 1];
+        return std::binary_search(beg, end, static_cast<std::uint32_t>(callee));
+    }
+
+    /*
+    tarjan's algorithm with an explicit stack of (function, next callee)
+    frames, so a long call chain does not overflow the native stack. a
+    component is complete when its root is left, after all components it
+    calls, which numbers the components callees first.
+    */
+    void CallGraph::BuildSCCs()
+    {
+        const auto N = static_cast<std::uint32_t>(_names.size());
+        std::vector<std::uint32_t> order(N, Unvisited);
+        std::vector<std::uint32_t> low(N);
+        std::vector<std::uint8_t> isOnStack(N, 0);
+        std::vector<std::uint32_t> stack;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> frames;
+        std::uint32_t visited = 0;
+
+        _sccs.assign(N, 0);
+        _sccFuncs.clear();
+        _sccFuncs.reserve(N);
+        _sccOffsets.assign(1, 0);
+
+        const auto enter = [&](std::uint32_t func)
+        {
+            order[func] = low[func] = visited++;
+            stack.push_back(func);
+            isOnStack[func] = 1;
+            frames.emplace_back(func, _calleeOffsets[func]);
+        };
+
+        for (std::uint32_t root = 0; root < N; ++root)
+        {
+            if (Unvisited != order[root])
+                continue;
+
+            enter(root);
+            while (!frames.empty())
+            {
+                const auto func = frames.back().first;
+                if (frames.back().second < _calleeOffsets[func + 1])
+                {
+                    const auto callee = _callees[frames.back().second++];
+                    if (Unvisited == order[callee])
+                        enter(callee);
+                    else if (isOnStack[callee])
+                        low[func] = std::min(low[func], order[callee]);
+                    continue;
+                }
+
+                frames.pop_back();
+                if (!frames.empty())
+                {
+                    const auto caller = frames.back().first;
+                    low[caller] = std::min(low[caller], low[func]);
+                }
+                if (low[func] != order[func])
+                    continue;
+
+                const auto scc = static_cast<std::uint32_t>(_sccOffsets.size() - 1);
+                std::uint32_t member;
+                do
+                {
+                    member = stack.back();
+                    stack.pop_back();
+                    isOnStack[member] = 0;
+                    _sccs[member] = scc;
+                    _sccFuncs.push_back(member);
+                } while (member != func);
+                _sccOffsets.push_back(static_cast<std::uint32_t>(_sccFuncs.size()));
+            }
+        }
+    }
+
+    const std::size_t CallGraphCache::DefaultCapacity;
+
+    CallGraphCache::CallGraphCache(std::size_t capacity)
+        : _capacity(capacity)
+    {
+        if (0 == capacity)
+            throw std::logic_error("call graph cache capacity must not be zero");
+    }
+
+    std::uint64_t CallGraphCache::Hash(const TokenList& tokens)
+    {
+        // FNV-1a of type and value of every token, positions are left out
+        std::uint64_t hash = 14695981039346656037ull;
+        const auto add = [&hash](unsigned char byte)
+        {
+            hash ^= byte;
+            hash *= 1099511628211ull;
+        };
+        for (const auto& token : tokens)
+        {
+            add(static_cast<unsigned char>(token.GetType()));
+            for (const auto c : token.GetValueString())
+                add(static_cast<unsigned char>(c));
+            add(0);
+        }
+        return hash;
+    }
+
+    std::shared_ptr<const CallGraph> CallGraphCache::Get(const FileAST& file, const TokenList& tokens)
+    {
+        const auto hash = Hash(tokens);
+        const auto& funcs = file.GetFuncs();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            const auto it = _graphs.find(hash);
+            if (it != _graphs.end())
+            {
+                // the functions are compared in case of hash collision
+                const auto& graph = *it->second->second;
+                auto isSame = graph.GetFuncCount() == funcs.size();
+                for (std::size_t i = 0; isSame && i < funcs.size(); ++i)
+                    isSame = graph.GetName(i) == funcs[i]->GetName();
+                if (isSame)
+                {
+                    _entries.splice(_entries.begin(), _entries, it->second);
+                    return it->second->second;
+                }
+            }
+        }
+
+        // built out of the lock, two threads missing the same file both build it
+        auto graph = std::make_shared<const CallGraph>(file);
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto it = _graphs.find(hash);
+        if (it != _graphs.end())
+        {
+            it->second->second = graph;
+            _entries.splice(_entries.begin(), _entries, it->second);
+            return graph;
+        }
+
+        _entries.emplace_front(hash, graph);
+        _graphs.emplace(hash, _entries.begin());
+        if (_entries.size() > _capacity)
+        {
+            _graphs.erase(_entries.back().first);
+            _entries.pop_back();
+        }
+        return graph;
+    }
+
+    std::size_t CallGraphCache::GetSize() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _graphs.size();
+    }
+
+    void CallGraphCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _graphs.clear();
+        _entries.clear();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "all_ast.h"
+#include "tokenizer.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace c0
+{
+    /*
+    which function calls which in a file, function i is file.GetFuncs()[i].
+    callees and callers of a function are sorted without duplicates, stored
+    in one array each with offsets per function. calls are resolved by name
+    as all functions are global, so a tree only parsed can be used too.
+
+    strongly connected components are numbered callees first, so visiting
+    them in order is bottom-up, and a function is recursive if its component
+    has more than one function or it calls itself. the graph keeps no ast
+    pointer and can be shared by files of the same source.
+    */
+    class CallGraph
+    {
+    public:
+        CallGraph() = default;
+        explicit CallGraph(const FileAST& file);
+
+        std::size_t GetFuncCount() const { return _names.size(); }
+        const str_t& GetName(std::size_t func) const { return _names[func]; }
+
+        std::size_t GetCalleeCount(std::size_t func) const { return _calleeOffsets[func + 1] - _calleeOffsets[func]; }
+        std::size_t GetCallee(std::size_t func, std::size_t i) const { return _callees[_calleeOffsets[func] + i]; }
+        std::size_t GetCallerCount(std::size_t func) const { return _callerOffsets[func + 1] - _callerOffsets[func]; }
+        std::size_t GetCaller(std::size_t func, std::size_t i) const { return _callers[_callerOffsets[func] + i]; }
+        bool IsCalling(std::size_t func, std::size_t callee) const;
+
+        std::size_t GetSCCCount() const { return _sccOffsets.size() - 1; }
+        std::size_t GetSCC(std::size_t func) const { return _sccs[func]; }
+        std::size_t GetSCCSize(std::size_t scc) const { return _sccOffsets[scc + 1] - _sccOffsets[scc]; }
+        std::size_t GetSCCFunc(std::size_t scc, std::size_t i) const { return _sccFuncs[_sccOffsets[scc] + i]; }
+        bool IsRecursive(std::size_t func) const { return GetSCCSize(GetSCC(func)) > 1 || IsCalling(func, func); }
+
+    private:
+        void BuildSCCs();
+
+    private:
+        std::vector<str_t> _names;
+        std::vector<std::uint32_t> _calleeOffsets = { 0 };
+        std::vector<std::uint32_t> _callees;
+        std::vector<std::uint32_t> _callerOffsets = { 0 };
+        std::vector<std::uint32_t> _callers;
+        std::vector<std::uint32_t> _sccs;       // component of each function
+        std::vector<std::uint32_t> _sccOffsets = { 0 };
+        std::vector<std::uint32_t> _sccFuncs;
+    };
+
+    /*
+    call graphs of files by hash of their tokens, a file of the same tokens
+    as one seen before, e.g. only its spacing or comments changed, gets the
+    same graph without walking the tree. at most capacity graphs are kept,
+    the least recently used one is dropped for a new one, so an editor
+    seeing a new token stream on every change keeps bounded memory. Get
+    may be called from many threads.
+    */
+    class CallGraphCache
+    {
+    public:
+        static const std::size_t DefaultCapacity = 64;
+
+        explicit CallGraphCache(std::size_t capacity = DefaultCapacity);
+
+        static std::uint64_t Hash(const TokenList& tokens);
+
+        std::shared_ptr<const CallGraph> Get(const FileAST& file, const TokenList& tokens);
+
+        std::size_t GetCapacity() const { return _capacity; }
+        std::size_t GetSize() const;
+        void Clear();
+
+    private:
+        using Entry = std::pair<std::uint64_t, std::shared_ptr<const CallGraph>>;
+
+        const std::size_t _capacity;
+        mutable std::mutex _mutex;
+        std::list<Entry> _entries;      // most recently used first
+        std::unordered_map<std::uint64_t, std::list<Entry>::iterator> _graphs;
+    };
+}
@@ -0,0 +1,435 @@
+#include "cfg.h"
+#include <algorithm>
+
+namespace c0
+{
+    BitVector::BitVector(std::size_t size, bool value)
+        : _words((size + 63) / 64)
+        , _size(size)
+    {
+        SetAll(value);
+    }
+
+    void BitVector::SetAll(bool value)
+    {
+        for (auto& word : _words)
+            word = value ? ~std::uint64_t(0) : 0;
+        if (value && 0 != _size % 64)
+            _words.back() = (std::uint64_t(1) << (_size % 64)) - 1;
+    }
+
+    bool BitVector::IntersectWith(const BitVector& other)
+    {
+        std::uint64_t changed = 0;
+        for (std::size_t i = 0, N = _words.size(); i < N; ++i)
+        {
+            const auto word = _words[i] & other._words[i];
+            changed |= word ^ _words[i];
+            _words[i] = word;
+        }
+        return 0 != changed;
+    }
+
+    bool BitVector::UnionWith(const BitVector& other)
+    {
+        std::uint64_t changed = 0;
+        for (std::size_t i = 0, N = _words.size(); i < N; ++i)
+        {
+            const auto word = _words[i] | other._words[i];
+            changed |= word ^ _words[i];
+            _words[i] = word;
+        }
+        return 0 != changed;
+    }
+
+    bool BitVector::Subtract(const BitVector& other)
+    {
+        std::uint64_t changed = 0;
+        for (std::size_t i = 0, N = _words.size(); i < N; ++i)
+        {
+            const auto word = _words[i] & ~other._words[i];
+            changed |= word ^ _words[i];
+            _words[i] = word;
+        }
+        return 0 != changed;
+    }
+
+    namespace
+    {
+        // a condition of a literal without relational operator, as in while (1)
+        bool IsAlwaysTrue(const BinaryExprAST& cond)
+        {
+            if (cond.IsExplicit())
+                return false;
+            const auto& expr = *cond.GetLeftExpr();
+            switch (expr.GetASTType())
+            {
+            case ASTType::IntExpr: return 0 != expr.GetInt();
+            case ASTType::CharExpr: return 0 != expr.GetChar();
+            default: return false;
+            }
+        }
+
+        // values grouped by block with a counting sort, keeping the order they were found in
+        template<typename T>
+        void GroupByBlock(std::size_t blockCount, const std::vector<std::pair<std::uint32_t, T>>& pairs,
+            std::vector<std::uint32_t>& offsets, std::vector<T>& values)
+        {
+            offsets.assign(blockCount + 1, 0);
+            for (const auto& pair : pairs)
+                ++offsets[pair.first + 1];
+            for (std::size_t i = 1; i <= blockCount; ++i)
+                offsets[i] += offsets[i - 1];
+
+            values.resize(pairs.size());
+            auto next = offsets;
+            for (const auto& pair : pairs)
+                values[next[pair.first]++] = pair.second;
+        }
+    }
+
+    const std::size_t CFG::Entry;
+    const std::size_t CFG::Exit;
+    const std::size_t CFG::NoBlock;
+    const std::uint32_t CFG::None;
+
+    CFG::CFG(const FuncDeclAST& func)
+    {
+        NewBlock();
+        NewBlock();
+
+        // loop conditions start blocks of their own, so Entry has no predecessor
+        _current = Entry;
+        if (nullptr != func.GetBlockStmt())
+            AddStmt(*func.GetBlockStmt());
+        AddEdge(_current, Exit);
+
+        BuildArrays();
+        BuildRPO();
+        BuildDominators();
+    }
+
+    bool CFG::Dominates(std::size_t a, std::size_t b) const
+    {
+        if (!IsReachable(a) || !IsReachable(b))
+            return false;
+        return _domPre[a] <= _domPre[b] && _domPre[b] <= _domLast[a];
+    }
+
+    void CFG::Jump(std::uint32_t to)
+    {
+        AddEdge(_current, to);
+        _current = NewBlock();
+    }
+
+    void CFG::BuildArrays()
+    {
+        GroupByBlock(_blockCount, _elementBlocks, _elementOffsets, _elements);
+        GroupByBlock(_blockCount, _edges, _succOffsets, _succs);
+        for (auto& edge : _edges)
+            std::swap(edge.first, edge.second);
+        GroupByBlock(_blockCount, _edges, _predOffsets, _preds);
+
+        // only needed while building
+        std::vector<std::pair<std::uint32_t, const AST*>>().swap(_elementBlocks);
+        std::vector<std::pair<std::uint32_t, std::uint32_t>>().swap(_edges);
+    }
+
+    /*
+    depth first search from Entry with an explicit stack of (block, next
+    successor) frames, a block is appended when it is left, which is post-
+    order, and the order is reversed at the end.
+    */
+    void CFG::BuildRPO()
+    {
+        _rpoNumbers.assign(_blockCount, None);
+        _rpo.clear();
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> frames;
+        const auto enter = [&](std::uint32_t block)
+        {
+            _rpoNumbers[block] = 0;
+            frames.emplace_back(block, _succOffsets[block]);
+        };
+
+        enter(static_cast<std::uint32_t>(Entry));
+        while (!frames.empty())
+        {
+            const auto block = frames.back().first;
+            if (frames.back().second < _succOffsets[block + 1])
+            {
+                const auto succ = _succs[frames.back().second++];
+                if (None == _rpoNumbers[succ])
+                    enter(succ);
+                continue;
+            }
+            frames.pop_back();
+            _rpo.push_back(block);
+        }
+
+        std::reverse(_rpo.begin(), _rpo.end());
+        for (std::uint32_t i = 0, N = static_cast<std::uint32_t>(_rpo.size()); i < N; ++i)
+            _rpoNumbers[_rpo[i]] = i;
+    }
+
+    /*
+    cooper, harvey and kennedy, "a simple, fast dominance algorithm": the
+    immediate dominator of a block is the nearest common ancestor of its
+    processed predecessors, found by walking up the tree from both by rpo
+    number. blocks are visited in rpo until nothing changes, two sweeps for
+    the structured flow of c0.
+    */
+    void CFG::BuildDominators()
+    {
+        _idoms.assign(_blockCount, None);
+        _idoms[Entry] = static_cast<std::uint32_t>(Entry);
+
+        const auto intersect = [this](std::uint32_t a, std::uint32_t b)
+        {
+            while (a != b)
+            {
+                while (_rpoNumbers[a] > _rpoNumbers[b])
+                    a = _idoms[a];
+                while (_rpoNumbers[b] > _rpoNumbers[a])
+                    b = _idoms[b];
+            }
+            return a;
+        };
+
+        for (auto changed = true; changed;)
+        {
+            changed = false;
+            for (std::size_t i = 1, N = _rpo.size(); i < N; ++i)
+            {
+                const auto block = _rpo[i];
+                auto idom = None;
+                for (auto j = _predOffsets[block]; j < _predOffsets[block + 1]; ++j)
+                {
+                    const auto pred = _preds[j];
+                    if (None == _idoms[pred])
+                        continue;
+                    idom = None == idom ? pred : intersect(pred, idom);
+                }
+                if (idom != _idoms[block])
+                {
+                    _idoms[block] = idom;
+                    changed = true;
+                }
+            }
+        }
+
+        // children in rpo, then the tree numbered in preorder
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> children;
+        children.reserve(_rpo.size());
+        for (std::size_t i = 1, N = _rpo.size(); i < N; ++i)
+            children.emplace_back(_idoms[_rpo[i]], _rpo[i]);
+        GroupByBlock(_blockCount, children, _domOffsets, _domChildren);
+
+        _domPre.assign(_blockCount, None);
+        _domLast.assign(_blockCount, None);
+        std::uint32_t visited = 0;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> frames;
+        frames.emplace_back(static_cast<std::uint32_t>(Entry), _domOffsets[Entry]);
+        _domPre[Entry] = visited++;
+        while (!frames.empty())
+        {
+            const auto block = frames.back().first;
+            if (frames.back().second < _domOffsets[block + 1])
+            {
+                const auto child = _domChildren[frames.back().second++];
+                _domPre[child] = visited++;
+                frames.emplace_back(child, _domOffsets[child]);
+                continue;
+            }
+            frames.pop_back();
+            _domLast[block] = visited - 1;
+        }
+    }
+
+    void CFG::AddStmt(const StmtAST& stmt)
+    {
+        switch (stmt.GetASTType())
+        {
+        case ASTType::BlockStmt:
+        {
+            const auto& block = static_cast<const BlockStmtAST&>(stmt);
+            for (const auto& var : block.GetVars())
+                AddElement(*var);
+            for (const auto& child : block.GetStmts())
+                AddStmt(*child);
+            break;
+        }
+
+        case ASTType::PrintStmt:
+        case ASTType::ScanStmt:
+        case ASTType::AssignStmt:
+        case ASTType::FuncCallStmt:
+            AddElement(stmt);
+            break;
+
+        case ASTType::IfStmt: AddIfStmt(static_cast<const IfStmtAST&>(stmt)); break;
+        case ASTType::SwitchStmt: AddSwitchStmt(static_cast<const SwitchStmtAST&>(stmt)); break;
+        case ASTType::WhileStmt: AddWhileStmt(static_cast<const WhileStmtAST&>(stmt)); break;
+        case ASTType::DoStmt: AddDoStmt(static_cast<const DoStmtAST&>(stmt)); break;
+        case ASTType::ForStmt: AddForStmt(static_cast<const ForStmtAST&>(stmt)); break;
+
+        case ASTType::LabeledStmt:
+            if (nullptr != static_cast<const LabeledStmtAST&>(stmt).GetStmt())
+                AddStmt(*static_cast<const LabeledStmtAST&>(stmt).GetStmt());
+            break;
+
+        case ASTType::BreakStmt:
+            AddElement(stmt);
+            Jump(_breakTargets.back());
+            break;
+
+        case ASTType::ContinueStmt:
+            AddElement(stmt);
+            Jump(_continueTargets.back());
+            break;
+
+        case ASTType::ReturnStmt:
+            AddElement(stmt);
+            Jump(Exit);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void CFG::AddIfStmt(const IfStmtAST& stmt)
+    {
+        AddElement(*stmt.GetIfCond());
+        const auto cond = _current;
+
+        _current = NewBlock();
+        AddEdge(cond, _current);
+        AddStmt(*stmt.GetIFStmt());
+        const auto ifEnd = _current;
+
+        auto elseEnd = cond;
+        if (nullptr != stmt.GetElseStmt())
+        {
+            _current = NewBlock();
+            AddEdge(cond, _current);
+            AddStmt(*stmt.GetElseStmt());
+            elseEnd = _current;
+        }
+
+        _current = NewBlock();
+        AddEdge(ifEnd, _current);
+        AddEdge(elseEnd, _current);
+    }
+
+    void CFG::AddSwitchStmt(const SwitchStmtAST& stmt)
+    {
+        AddElement(*stmt.GetExpr());
+        const auto head = _current;
+        const auto exit = NewBlock();
+
+        _breakTargets.push_back(exit);
+        auto hasDefault = false;
+        auto prev = head;
+        for (const auto& caseStmt : stmt.GetStmts())
+        {
+            _current = NewBlock();
+            AddEdge(head, _current);
+            if (prev != head)
+                AddEdge(prev, _current);
+
+            // default is kept as the statement itself
+            if (caseStmt->GetASTType() != ASTType::LabeledStmt)
+                hasDefault = true;
+            AddStmt(*caseStmt);
+            prev = _current;
+        }
+        _breakTargets.pop_back();
+
+        if (prev != head)
+            AddEdge(prev, exit);
+        if (!hasDefault)
+            AddEdge(head, exit);
+        _current = exit;
+    }
+
+    void CFG::AddWhileStmt(const WhileStmtAST& stmt)
+    {
+        const auto cond = NewBlock();
+        AddEdge(_current, cond);
+        _current = cond;
+        AddElement(*stmt.GetCond());
+
+        const auto body = NewBlock();
+        const auto exit = NewBlock();
+        AddEdge(cond, body);
+        if (!IsAlwaysTrue(*stmt.GetCond()))
+            AddEdge(cond, exit);
+
+        _breakTargets.push_back(exit);
+        _continueTargets.push_back(cond);
+        _current = body;
+        AddStmt(*stmt.GetStmt());
+        AddEdge(_current, cond);
+        _breakTargets.pop_back();
+        _continueTargets.pop_back();
+
+        _current = exit;
+    }
+
+    void CFG::AddDoStmt(const DoStmtAST& stmt)
+    {
+        const auto body = NewBlock();
+        const auto cond = NewBlock();
+        const auto exit = NewBlock();
+        AddEdge(_current, body);
+
+        _breakTargets.push_back(exit);
+        _continueTargets.push_back(cond);
+        _current = body;
+        AddStmt(*stmt.GetStmt());
+        AddEdge(_current, cond);
+        _breakTargets.pop_back();
+        _continueTargets.pop_back();
+
+        _current = cond;
+        AddElement(*stmt.GetCond());
+        AddEdge(cond, body);
+        if (!IsAlwaysTrue(*stmt.GetCond()))
+            AddEdge(cond, exit);
+        _current = exit;
+    }
+
+    void CFG::AddForStmt(const ForStmtAST& stmt)
+    {
+        for (const auto& expr : stmt.GetInitExprs())
+            AddElement(*expr);
+
+        const auto cond = NewBlock();
+        AddEdge(_current, cond);
+        _current = cond;
+        if (nullptr != stmt.GetCond())
+            AddElement(*stmt.GetCond());
+
+        const auto body = NewBlock();
+        const auto update = NewBlock();
+        const auto exit = NewBlock();
+        AddEdge(cond, body);
+        if (nullptr != stmt.GetCond() && !IsAlwaysTrue(*stmt.GetCond()))
+            AddEdge(cond, exit);
+
+        _breakTargets.push_back(exit);
+        _continueTargets.push_back(update);
+        _current = body;
+        AddStmt(*stmt.GetBody());
+        AddEdge(_current, update);
+        _breakTargets.pop_back();
+        _continueTargets.pop_back();
+
+        _current = update;
+        for (const auto& expr : stmt.GetUpdateExprs())
+            AddElement(*expr);
+        AddEdge(update, cond);
+        _current = exit;
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "all_ast.h"
+
+namespace c0
+{
+    /*
+    fixed size set of bits for data-flow passes, one word holds 64 members,
+    bits past the size are always clear.
+    */
+    class BitVector
+    {
+    public:
+        BitVector() = default;
+        BitVector(std::size_t size, bool value);
+
+        std::size_t GetSize() const { return _size; }
+        bool Test(std::size_t i) const { return 0 != (_words[i / 64] & (std::uint64_t(1) << (i % 64))); }
+        void Set(std::size_t i) { _words[i / 64] |= std::uint64_t(1) << (i % 64); }
+        void Reset(std::size_t i) { _words[i / 64] &= ~(std::uint64_t(1) << (i % 64)); }
+        void SetAll(bool value);
+
+        // each returns true if this is changed
+        bool IntersectWith(const BitVector& other);
+        bool UnionWith(const BitVector& other);
+        bool Subtract(const BitVector& other);
+
+        bool operator==(const BitVector& other) const { return _size == other._size && _words == other._words; }
+        bool operator!=(const BitVector& other) const { return !(*this == other); }
+
+    private:
+        std::vector<std::uint64_t> _words;
+        std::size_t _size = 0;
+    };
+
+    /*
+    control flow graph of one function body. a basic block is a list of
+    elements run in order, an element is one of
+
+        print, scan, assignment, function call, break, continue and return
+        statement, local variable declaration, condition of if, while, do
+        and for, switch expression, for init and update expression
+
+    so compound statements only show as edges. block Entry starts the body
+    and block Exit follows every return and the end of the body. a block
+    after break, continue or return is left with no predecessor, and every
+    block not reachable from Entry is dead code. switch cases fall through
+    to the next case, and a loop on a literal condition as while (1) is left
+    only by break or return.
+
+    elements, successors and predecessors are each stored in one array with
+    offsets per block, successors of a condition are in the order of the
+    source. reachable blocks are numbered in reverse post-order, where a
+    block comes before all its successors but along back edges of loops, so
+    a forward data-flow pass visiting blocks in that order converges in few
+    sweeps. the dominator tree is computed with the algorithm of cooper,
+    harvey and kennedy and numbered in preorder, so Dominates is constant
+    time. unreachable blocks have no rpo number and no immediate dominator.
+    */
+    class CFG
+    {
+    public:
+        static const std::size_t Entry = 0;
+        static const std::size_t Exit = 1;
+        static const std::size_t NoBlock = static_cast<std::size_t>(-1);
+
+        explicit CFG(const FuncDeclAST& func);
+
+        std::size_t GetBlockCount() const { return _elementOffsets.size() - 1; }
+        std::size_t GetElementCount(std::size_t block) const { return _elementOffsets[block + 1] - _elementOffsets[block]; }
+        const AST& GetElement(std::size_t block, std::size_t i) const { return *_elements[_elementOffsets[block] + i]; }
+        std::size_t GetSuccCount(std::size_t block) const { return _succOffsets[block + 1] - _succOffsets[block]; }
+        std::size_t GetSucc(std::size_t block, std::size_t i) const { return _succs[_succOffsets[block] + i]; }
+        std::size_t GetPredCount(std::size_t block) const { return _predOffsets[block + 1] - _predOffsets[block]; }
+        std::size_t GetPred(std::size_t block, std::size_t i) const { return _preds[_predOffsets[block] + i]; }
+
+        bool IsReachable(std::size_t block) const { return NoBlock != GetRPONumber(block); }
+        std::size_t GetRPOCount() const { return _rpo.size(); }
+        std::size_t GetRPOBlock(std::size_t i) const { return _rpo[i]; }
+        std::size_t GetRPONumber(std::size_t block) const { return ToBlock(_rpoNumbers[block]); }
+
+        // Entry is its own immediate dominator
+        std::size_t GetIDom(std::size_t block) const { return ToBlock(_idoms[block]); }
+        std::size_t GetDomChildCount(std::size_t block) const { return _domOffsets[block + 1] - _domOffsets[block]; }
+        std::size_t GetDomChild(std::size_t block, std::size_t i) const { return _domChildren[_domOffsets[block] + i]; }
+        // every path from Entry to b goes through a, a block dominates itself
+        bool Dominates(std::size_t a, std::size_t b) const;
+
+    private:
+        static const std::uint32_t None = static_cast<std::uint32_t>(-1);
+        static std::size_t ToBlock(std::uint32_t i) { return None == i ? NoBlock : i; }
+
+        std::uint32_t NewBlock() { return _blockCount++; }
+        void AddEdge(std::uint32_t from, std::uint32_t to) { _edges.emplace_back(from, to); }
+        void AddElement(const AST& ast) { _elementBlocks.emplace_back(_current, &ast); }
+        // current block ends with a jump, the code after it starts a block without predecessor
+        void Jump(std::uint32_t to);
+
+        void AddStmt(const StmtAST& stmt);
+        void AddIfStmt(const IfStmtAST& stmt);
+        void AddSwitchStmt(const SwitchStmtAST& stmt);
+        void AddWhileStmt(const WhileStmtAST& stmt);
+        void AddDoStmt(const DoStmtAST& stmt);
+        void AddForStmt(const ForStmtAST& stmt);
+
+        void BuildArrays();
+        void BuildRPO();
+        void BuildDominators();
+
+    private:
+        // while building, elements and edges in the order they are found
+        std::uint32_t _blockCount = 0;
+        std::uint32_t _current = 0;
+        std::vector<std::pair<std::uint32_t, const AST*>> _elementBlocks;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> _edges;
+        std::vector<std::uint32_t> _breakTargets;
+        std::vector<std::uint32_t> _continueTargets;
+
+        std::vector<std::uint32_t> _elementOffsets;
+        std::vector<const AST*> _elements;
+        std::vector<std::uint32_t> _succOffsets;
+        std::vector<std::uint32_t> _succs;
+        std::vector<std::uint32_t> _predOffsets;
+        std::vector<std::uint32_t> _preds;
+        std::vector<std::uint32_t> _rpo;
+        std::vector<std::uint32_t> _rpoNumbers;
+        std::vector<std::uint32_t> _idoms;
+        std::vector<std::uint32_t> _domOffsets;
+        std::vector<std::uint32_t> _domChildren;
+        std::vector<std::uint32_t> _domPre;      // preorder number in the dominator tree
+        std::vector<std::uint32_t> _domLast;     // largest preorder number in the subtree
+    };
+}
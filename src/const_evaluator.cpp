@@ -0,0 +1,217 @@
+#include "const_evaluator.h"
+#include <limits>
+
+namespace c0
+{
+    namespace
+    {
+        // false for a float out of the range of int, which has no defined conversion
+        bool ConvertConstValue(ConstValue& value, VarType type)
+        {
+            switch (type)
+            {
+            case VarType::Int:
+            case VarType::Char:
+                if (VarType::Float == value.type)
+                {
+                    if (!(value.f > float_t(std::numeric_limits<int_t>::min()) - 1.0
+                        && value.f < float_t(std::numeric_limits<int_t>::max()) + 1.0))
+                        return false;
+                    value.i = int_t(value.f);
+                }
+                if (VarType::Char == type)
+                    value.i = int_t(char_t(value.i));
+                break;
+
+            case VarType::Float:
+                if (VarType::Float != value.type)
+                    value.f = float_t(value.i);
+                break;
+
+            default:
+                return false;
+            }
+
+            value.type = type;
+            return true;
+        }
+
+        // int arithmetic of c0 wraps around
+        int_t WrapInt(std::uint32_t v) { return static_cast<int_t>(v); }
+    }
+
+    ConstEvaluator::ConstEvaluator(const FileAST& file)
+        : _entries(file, Entry())
+    {
+        // a global can only use the globals before it, evaluated in order the recursion stays shallow
+        for (const auto& var : file.GetVars())
+        {
+            if (var->IsConst() && var->HasExpr())
+                IsConst(*var->GetExpr());
+        }
+    }
+
+    bool ConstEvaluator::Evaluate(const ExprAST& expr, ConstValue& value)
+    {
+        // no reference to the entry is kept, the attribute grows for nodes created later
+        switch (_entries[expr].state)
+        {
+        case State::Const:
+            value = _entries[expr].value;
+            return true;
+        case State::Evaluating:
+        case State::NotConst:
+            return false;
+        default:
+            break;
+        }
+
+        _entries[expr].state = State::Evaluating;
+        ConstValue result;
+        const auto isConst = EvaluateImpl(expr, result);
+        auto& entry = _entries[expr];
+        entry.state = isConst ? State::Const : State::NotConst;
+        entry.value = result;
+        if (isConst)
+            value = result;
+        return isConst;
+    }
+
+    bool ConstEvaluator::EvaluateImpl(const ExprAST& expr, ConstValue& value)
+    {
+        switch (expr.GetASTType())
+        {
+        case ASTType::IntExpr:
+            value.type = VarType::Int;
+            value.i = expr.GetInt();
+            return true;
+
+        case ASTType::CharExpr:
+            value.type = VarType::Char;
+            value.i = int_t(expr.GetChar());
+            return true;
+
+        case ASTType::FloatExpr:
+            value.type = VarType::Float;
+            value.f = expr.GetFloat();
+            return true;
+
+        case ASTType::BraceExpr:
+            return Evaluate(*static_cast<const BraceExprAST&>(expr).GetExpr(), value);
+
+        case ASTType::CastExpr:
+        {
+            const auto& cast = static_cast<const CastExprAST&>(expr);
+            return Evaluate(*cast.GetExpr(), value) && ConvertConstValue(value, cast.GetVarType());
+        }
+
+        case ASTType::UnaryExpr:
+        {
+            const auto& unary = static_cast<const UnaryExprAST&>(expr);
+            if (!Evaluate(*unary.GetExpr(), value))
+                return false;
+            if (UnaryType::Negative != unary.GetUT())
+                return true;
+            if (VarType::Float == value.type)
+                value.f = -value.f;
+            else
+                value.i = WrapInt(0u - static_cast<std::uint32_t>(value.i));
+            return ConvertConstValue(value, value.type);
+        }
+
+        case ASTType::BinaryExpr:
+        {
+            const auto& binary = static_cast<const BinaryExprAST&>(expr);
+            if (binary.IsCond())
+                return false;
+
+            ConstValue right;
+            if (!Evaluate(*binary.GetLeftExpr(), value) || !Evaluate(*binary.GetRightExpr(), right))
+                return false;
+            // operands of a tree not analysed have no cast yet
+            const auto type = MergeVarType(value.type, right.type);
+            if (!ConvertConstValue(value, type) || !ConvertConstValue(right, type))
+                return false;
+
+            if (VarType::Float == type)
+            {
+                switch (binary.GetOT())
+                {
+                case BinaryType::Add: value.f += right.f; return true;
+                case BinaryType::Sub: value.f -= right.f; return true;
+                case BinaryType::Mul: value.f *= right.f; return true;
+                case BinaryType::Div:
+                    if (0.0 == right.f)
+                        return false;
+                    value.f /= right.f;
+                    return true;
+                default: return false;
+                }
+            }
+
+            const auto a = static_cast<std::uint32_t>(value.i);
+            const auto b = static_cast<std::uint32_t>(right.i);
+            switch (binary.GetOT())
+            {
+            case BinaryType::Add: value.i = WrapInt(a + b); return true;
+            case BinaryType::Sub: value.i = WrapInt(a - b); return true;
+            case BinaryType::Mul: value.i = WrapInt(a * b); return true;
+            case BinaryType::Div:
+                if (0 == right.i || (std::numeric_limits<int_t>::min() == value.i && -1 == right.i))
+                    return false;
+                value.i /= right.i;
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        case ASTType::IdentExpr:
+        {
+            const auto& ident = static_cast<const IdentExprAST&>(expr);
+            const AST* decl = ident.GetDecl();
+            if (nullptr == decl)
+                decl = ident.GetSymbol(ident.GetName(), true);
+            if (nullptr == decl || decl->GetASTType() != ASTType::VarDecl)
+                return false;
+            const auto var = static_cast<const VarDeclAST*>(decl);
+            if (!var->IsConst())
+                return false;
+            return var->HasExpr() && Evaluate(*var->GetExpr(), value) && ConvertConstValue(value, var->GetVarType());
+        }
+
+        default:
+            return false;
+        }
+    }
+
+    ExprASTPtr ConstEvaluator::Fold(ASTContext& context, ExprASTPtr expr)
+    {
+        switch (expr->GetASTType())
+        {
+        case ASTType::IntExpr:
+        case ASTType::CharExpr:
+        case ASTType::FloatExpr:
+            return expr;
+        default:
+            break;
+        }
+
+        ConstValue value;
+        if (!Evaluate(*expr, value))
+            return expr;
+
+        ExprASTPtr literal = nullptr;
+        switch (value.type)
+        {
+        case VarType::Int: literal = context.New<IntExprAST>(expr->GetParent(), value.i); break;
+        case VarType::Char: literal = context.New<CharExprAST>(expr->GetParent(), value.GetChar()); break;
+        default: literal = context.New<FloatExprAST>(expr->GetParent(), value.f); break;
+        }
+        literal->SetTokenIndex(expr->GetTokenIndex());
+        auto& entry = _entries[*literal];
+        entry.state = State::Const;
+        entry.value = value;
+        return literal;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "all_ast.h"
+#include "ast_attribute.h"
+
+namespace c0
+{
+    struct ConstValue
+    {
+        VarType type = VarType::Nul;    // Int, Char or Float
+        int_t i = 0;                    // value of Int and Char
+        float_t f = 0.0;                // value of Float
+
+        int_t GetInt() const { return VarType::Float == type ? int_t(f) : i; }
+        char_t GetChar() const { return char_t(GetInt()); }
+        float_t GetFloat() const { return VarType::Float == type ? f : float_t(i); }
+    };
+
+    /*
+    folds constant expressions of a file: literals, and unary, binary, cast
+    and brace expressions over constants, and identifiers of const variables
+    with a constant initializer. a value is evaluated once per node and kept,
+    so a chain of const variables each using the one before is folded in
+    linear time. integer arithmetic wraps, division by zero, comparison,
+    string and any other expression is not constant, e.g.
+
+        ConstEvaluator consts(*file);
+        ConstValue value;
+        if (consts.Evaluate(*expr, value)) ... value.GetInt() ...
+
+    Fold gives a literal node in place of a constant expression for code
+    generation, the tree itself is not changed. semantic analyse does not
+    use it: const only makes a variable read-only, e.g. a const parameter
+    or a const local initialized from one is not a constant expression.
+    */
+    class ConstEvaluator
+    {
+    public:
+        explicit ConstEvaluator(const FileAST& file);
+
+        bool Evaluate(const ExprAST& expr, ConstValue& value);
+        bool IsConst(const ExprAST& expr) { ConstValue value; return Evaluate(expr, value); }
+
+        // literal of the value of expr with parent of expr created in context, expr itself if not constant or a literal
+        ExprASTPtr Fold(ASTContext& context, ExprASTPtr expr);
+
+    private:
+        enum class State : std::uint8_t
+        {
+            Unknown,
+            Evaluating,
+            Const,
+            NotConst,
+        };
+
+        struct Entry
+        {
+            State state = State::Unknown;
+            ConstValue value;
+        };
+
+        bool EvaluateImpl(const ExprAST& expr, ConstValue& value);
+
+    private:
+        ASTAttribute<Entry> _entries;
+    };
+}
@@ -40,25 +40,15 @@ namespace c0
                 return varlist;
             }
             const auto varName = token.GetString();
-            const auto t = parent->GetSymbolType(varName, false);
-            if (t != SymbolType::Nul)
-            {
-                err = AnalyseError("variable name repeated", token);
-                return varlist;
-            }
 
-            auto var = std::make_shared<VarDeclAST>(parent, false, isConst, varType, varName);
+            auto var = NewAST<VarDeclAST>(_cur - 1, parent, false, isConst, varType, varName);
             varlist.push_back(var);
 
             token = ReadToken();
 
             if (token.GetType() == TokenType::S_ASSIGN)
             {
-                auto expr = AnalyseExpr(parent, err, isConst);
-                if (err)
-                    return varlist;
-                expr = CheckInexplicitTypeCast(parent, err, token, expr, varType, 
-                    "invalid variable declare, ");
+                auto expr = AnalyseExpr(parent, err);
                 if (err)
                     return varlist;
                 var->SetExpr(expr);
@@ -90,8 +80,11 @@ namespace c0
         '(' [<parameter-declaration-list>] ')'
     <parameter-declaration-list> ::=
         <parameter-declaration>{','<parameter-declaration>}
+
+    only <type-specifier><identifier><parameter-clause> is analysed,
+    the <compound-statement> is left for AnalyseFile.
     */
-    FuncDeclASTPtr Analyser::AnalyseFuncDecl(ASTPtr parent, AnalyseError& err)
+    FuncDeclASTPtr Analyser::AnalyseFuncSign(ASTPtr parent, AnalyseError& err)
     {
         auto token = ReadToken();
         const auto retType = TokenType2VarType(token.GetType());
@@ -108,6 +101,7 @@ namespace c0
             return nullptr;
         }
         const auto funcName = token.GetString();
+        const auto namePos = _cur - 1;
 
         token = ReadToken();
         if (token.GetType() != TokenType::S_LBRACES)
@@ -116,7 +110,7 @@ namespace c0
             return nullptr;
         }
 
-        auto func = std::make_shared<FuncDeclAST>(parent, retType, funcName);
+        auto func = NewAST<FuncDeclAST>(namePos, parent, retType, funcName);
 
         for (token = PeekToken(); 
             token.GetType() != TokenType::S_RBRACES; 
@@ -139,12 +133,6 @@ namespace c0
             return nullptr;
         }
 
-        auto block = AnalyseBlockStmt(func, err, retType, false, false);
-        if (err)
-            return nullptr;
-
-        func->SetBlockStmt(block);
-
         return func;
     }
 
@@ -176,13 +164,7 @@ namespace c0
             return nullptr;
         }
         const auto varName = token.GetString();
-        const auto t = parent->GetSymbolType(varName, false);
-        if (t != SymbolType::Nul)
-        {
-            err = AnalyseError("variable name repeated", token);
-            return nullptr;
-        }
 
-        return std::make_shared<VarDeclAST>(parent, true, isConst, varType, varName);
+        return NewAST<VarDeclAST>(_cur - 1, parent, true, isConst, varType, varName);
     }
 }
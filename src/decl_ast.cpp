@@ -33,7 +33,7 @@ namespace c0
     ASTPtr VarDeclAST::GetSymbol(const str_t& s, bool recusive) const
     {
         if (s == _name)
-            return const_cast<VarDeclAST* const>(this)->shared_from_this();
+            return const_cast<VarDeclAST*>(this);
         return DefaultGetSymbolImpl(s, recusive);
     }
 
@@ -59,13 +59,17 @@ namespace c0
         if (visitor.BegVisit(*this))
         {
             VISIT_AST_HELPER(_params);
-            _block->Accept(visitor);
+            if (nullptr != _block)
+                _block->Accept(visitor);
         }
         return visitor.EndVisit(*this);
     }
 
     SymbolType FuncDeclAST::GetSymbolType(const str_t& s, bool recusive) const
     {
+        DeclASTPtr decl = nullptr;
+        if (FindInSymbolTable(_symbols, s, recusive, decl))
+            return GetDeclSymbolType(decl);
         if (s == _name)
             return SymbolType::Func;
         GET_SYMBOLTYPE_HELPER(_params);
@@ -74,8 +78,11 @@ namespace c0
 
     ASTPtr FuncDeclAST::GetSymbol(const str_t& s, bool recusive) const
     {
+        DeclASTPtr decl = nullptr;
+        if (FindInSymbolTable(_symbols, s, recusive, decl))
+            return decl;
         if (s == _name)
-            return const_cast<FuncDeclAST* const>(this)->shared_from_this();
+            return const_cast<FuncDeclAST*>(this);
         GET_SYMBOL_HELPER(_params);
         return DefaultGetSymbolImpl(s, recusive);
     }
@@ -39,7 +39,7 @@ namespace c0
         const bool _isConst;
         VarType _vt;
         str_t _name;
-        ExprASTPtr _expr;
+        ExprASTPtr _expr = nullptr;
     };
 
     class FuncDeclAST : public DeclAST
@@ -64,10 +64,14 @@ namespace c0
         const VarDeclASTPtrList& GetParams() const { return _params; }
         BlockStmtASTPtr GetBlockStmt() const { return _block; }
 
+        // set by semantic analyse when the scope of the function is entered
+        void SetSymbolTable(const SymbolTable* symbols) { _symbols = symbols; }
+
     private:
         VarType _retType;
         str_t _name;
         VarDeclASTPtrList _params;
-        BlockStmtASTPtr _block;
+        BlockStmtASTPtr _block = nullptr;
+        const SymbolTable* _symbols = nullptr;
     };
 }
@@ -0,0 +1,191 @@
+#include "definite_assignment.h"
+#include "ast_visitor.h"
+#include <algorithm>
+
+namespace c0
+{
+    namespace
+    {
+        class LocalVarCollector : public StaticASTVisitor<LocalVarCollector>
+        {
+        public:
+            explicit LocalVarCollector(std::vector<const VarDeclAST*>& vars) : _vars(vars) {}
+
+            // a const variable always has its initializer
+            void VisitVarDecl(const VarDeclAST& ast)
+            {
+                if (!ast.IsConst())
+                    _vars.push_back(&ast);
+            }
+
+        private:
+            std::vector<const VarDeclAST*>& _vars;
+        };
+    }
+
+    /*
+    applies the elements of a block in order, either to gen and kill sets of
+    the block, or to the set of assigned variables while checking the reads.
+    */
+    class DefiniteAssignment::Transfer : public StaticASTVisitor<Transfer>
+    {
+    public:
+        Transfer(const DefiniteAssignment& owner, BitVector& gen, BitVector& kill)
+            : _owner(owner), _gen(&gen), _kill(&kill)
+        {}
+        Transfer(const DefiniteAssignment& owner, BitVector& assigned, std::vector<const IdentExprAST*>& uninitReads)
+            : _owner(owner), _assigned(&assigned), _uninitReads(&uninitReads)
+        {}
+
+        void VisitIdentExpr(const IdentExprAST& ast)
+        {
+            const auto i = GetIndex(ast.GetDecl());
+            if (NoVar != i && nullptr != _assigned && !_assigned->Test(i))
+                _uninitReads->push_back(&ast);
+        }
+
+        void VisitVarDecl(const VarDeclAST& ast)
+        {
+            VisitChildren(ast);
+            Update(&ast, ast.HasExpr());
+        }
+        void VisitAssignExpr(const AssignExprAST& ast)
+        {
+            VisitChildren(ast);
+            Update(ast.GetDecl(), true);
+        }
+        void VisitAssignStmt(const AssignStmtAST& ast)
+        {
+            VisitChildren(ast);
+            Update(ast.GetDecl(), true);
+        }
+        void VisitScanStmt(const ScanStmtAST& ast) { Update(ast.GetDecl(), true); }
+
+    private:
+        std::size_t GetIndex(const DeclAST* decl) const
+        {
+            if (nullptr == decl || decl->GetDeclType() != DeclType::Var)
+                return NoVar;
+            return _owner.GetVarIndex(static_cast<const VarDeclAST&>(*decl));
+        }
+
+        void Update(const DeclAST* decl, bool assigned)
+        {
+            const auto i = GetIndex(decl);
+            if (NoVar == i)
+                return;
+
+            if (nullptr != _assigned)
+            {
+                if (assigned)
+                    _assigned->Set(i);
+                else
+                    _assigned->Reset(i);
+            }
+            else if (assigned)
+            {
+                _gen->Set(i);
+                _kill->Reset(i);
+            }
+            else
+            {
+                _kill->Set(i);
+                _gen->Reset(i);
+            }
+        }
+
+    private:
+        const DefiniteAssignment& _owner;
+        BitVector* _gen = nullptr;
+        BitVector* _kill = nullptr;
+        BitVector* _assigned = nullptr;
+        std::vector<const IdentExprAST*>* _uninitReads = nullptr;
+    };
+
+    const std::size_t DefiniteAssignment::NoVar;
+
+    DefiniteAssignment::DefiniteAssignment(const FuncDeclAST& func, const CFG& cfg)
+    {
+        if (nullptr != func.GetBlockStmt())
+            LocalVarCollector(_vars).Visit(*func.GetBlockStmt());
+        if (!_vars.empty())
+        {
+            auto lastVarId = _firstVarId = _vars.front()->GetId();
+            for (const auto& var : _vars)
+            {
+                _firstVarId = std::min(_firstVarId, var->GetId());
+                lastVarId = std::max(lastVarId, var->GetId());
+            }
+            _varIndex.assign(lastVarId - _firstVarId + 1, 0);
+            for (std::size_t i = 0, N = _vars.size(); i < N; ++i)
+                _varIndex[_vars[i]->GetId() - _firstVarId] = static_cast<std::uint32_t>(i + 1);
+        }
+
+        const auto blockCount = cfg.GetBlockCount();
+        const auto varCount = _vars.size();
+
+        std::vector<BitVector> gen(blockCount, BitVector(varCount, false));
+        std::vector<BitVector> kill(blockCount, BitVector(varCount, false));
+        for (std::size_t block = 0; block < blockCount; ++block)
+        {
+            Transfer transfer(*this, gen[block], kill[block]);
+            for (std::size_t i = 0, N = cfg.GetElementCount(block); i < N; ++i)
+                transfer.Visit(cfg.GetElement(block, i));
+        }
+
+        _in.assign(blockCount, BitVector(varCount, true));
+        _out.assign(blockCount, BitVector(varCount, true));
+        _in[CFG::Entry].SetAll(false);
+
+        // paths from Entry only, reachable blocks in reverse post-order and a block of dead code not in the meet
+        BitVector out;
+        for (auto changed = true; changed;)
+        {
+            changed = false;
+            for (std::size_t i = 0, N = cfg.GetRPOCount(); i < N; ++i)
+            {
+                const auto block = cfg.GetRPOBlock(i);
+                auto& in = _in[block];
+                if (CFG::Entry != block)
+                {
+                    in.SetAll(true);
+                    for (std::size_t j = 0, M = cfg.GetPredCount(block); j < M; ++j)
+                    {
+                        const auto pred = cfg.GetPred(block, j);
+                        if (cfg.IsReachable(pred))
+                            in.IntersectWith(_out[pred]);
+                    }
+                }
+
+                out = in;
+                out.Subtract(kill[block]);
+                out.UnionWith(gen[block]);
+                if (out != _out[block])
+                {
+                    _out[block] = out;
+                    changed = true;
+                }
+            }
+        }
+
+        // reads in about the order of the source
+        for (std::size_t block = 0; block < blockCount; ++block)
+        {
+            if (!cfg.IsReachable(block))
+                continue;
+            auto assigned = _in[block];
+            Transfer transfer(*this, assigned, _uninitReads);
+            for (std::size_t i = 0, N = cfg.GetElementCount(block); i < N; ++i)
+                transfer.Visit(cfg.GetElement(block, i));
+        }
+    }
+
+    std::size_t DefiniteAssignment::GetVarIndex(const VarDeclAST& var) const
+    {
+        const auto id = var.GetId();
+        if (id < _firstVarId || id - _firstVarId >= _varIndex.size())
+            return NoVar;
+        const auto i = _varIndex[id - _firstVarId];
+        return 0 == i ? NoVar : i - 1;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "cfg.h"
+
+namespace c0
+{
+    /*
+    forward data-flow pass over the cfg of a function finding the local
+    variables definitely assigned at each point: on every path from Entry
+    the variable is declared with an initializer, assigned or scanned after
+    its declaration. a declaration without initializer unassigns it again,
+    as for a block entered once per loop iteration. parameters and globals
+    are always assigned and not tracked.
+
+    each block has one bit vector in and out, blocks are iterated in reverse
+    post-order until nothing changes, which on the structured flow of c0
+    takes a few passes over the function whatever its size. the in and out
+    sets are kept for optimizers, reads are found on the bindings of
+    semantic analyse so the ast must be analysed.
+    */
+    class DefiniteAssignment
+    {
+    public:
+        static const std::size_t NoVar = static_cast<std::size_t>(-1);
+
+        DefiniteAssignment(const FuncDeclAST& func, const CFG& cfg);
+
+        std::size_t GetVarCount() const { return _vars.size(); }
+        const VarDeclAST& GetVar(std::size_t i) const { return *_vars[i]; }
+        std::size_t GetVarIndex(const VarDeclAST& var) const;
+
+        // locals definitely assigned at the start and end of block
+        const BitVector& GetAssignedIn(std::size_t block) const { return _in[block]; }
+        const BitVector& GetAssignedOut(std::size_t block) const { return _out[block]; }
+
+        // reads of locals on a path where they are not assigned, reads in dead code are left out
+        const std::vector<const IdentExprAST*>& GetUninitReads() const { return _uninitReads; }
+
+    private:
+        class Transfer;
+
+    private:
+        std::vector<const VarDeclAST*> _vars;
+        // index + 1 by node id from the first local, 0 for not a local, sized by the function not the file
+        std::size_t _firstVarId = 0;
+        std::vector<std::uint32_t> _varIndex;
+        std::vector<BitVector> _in;
+        std::vector<BitVector> _out;
+        std::vector<const IdentExprAST*> _uninitReads;
+    };
+}
@@ -1,234 +1,118 @@
 #include "dump_visitor.h"
-#include "all_ast.h"
 #include <iostream>
 
 namespace c0
 {
-    bool DumpVisitor::BegVisit(const AST& ast)
+    void DumpVisitor::VisitAssignStmt(const AssignStmtAST& ast)
     {
-        ast.SetUserData(nullptr);
-        switch (ast.GetASTType())
+        Out() << ast.GetName() << " = " << ast.GetExpr()->ToString() << ";" << std::endl;
+    }
+
+    void DumpVisitor::VisitIfStmt(const IfStmtAST& ast)
+    {
+        Out() << "if (" << std::to_string(ast.GetIfCond()) << ")" << std::endl;
+        Body(*ast.GetIFStmt());
+
+        if (nullptr != ast.GetElseStmt())
         {
-        case ASTType::BinaryExpr:
-        case ASTType::CastExpr:
-        case ASTType::UnaryExpr:
-        case ASTType::BraceExpr:
-        case ASTType::IdentExpr:
-        case ASTType::IntExpr:
-        case ASTType::AssignExpr:
-        case ASTType::FuncCallExpr:
-            _stream << ast.ToString() << std::endl;
-            return false;
+            Out() << "else" << std::endl;
+            Body(*ast.GetElseStmt());
+        }
+    }
 
-        case ASTType::EmptyStmt:
-            Out() << ast.ToString() << std::endl;
-            break;
-        case ASTType::BlockStmt:
-            break;
-        case ASTType::PrintStmt:
-        case ASTType::ScanStmt:
-            Out() << ast.ToString() << std::endl;
-            return false;
-        case ASTType::AssignStmt:
+    void DumpVisitor::VisitSwitchStmt(const SwitchStmtAST& ast)
+    {
+        Out() << "switch (" << std::to_string(ast.GetExpr()) << ")" << std::endl;
+        Out() << "{" << std::endl;
+        for (const auto& stmt : ast.GetStmts())
+        {
+            if (stmt->GetASTType() == ASTType::LabeledStmt)
             {
-                auto& v = dynamic_cast<const AssignStmtAST&>(ast);
-                Out() << v.GetName() << " = " << v.GetExpr()->ToString() << ";" << std::endl;
-                return false;
+                Visit(*stmt);
+                continue;
             }
-        case ASTType::FuncCallStmt:
-            Out() << ast.ToString() << std::endl;
-            return false;
-        case ASTType::IfStmt:
-            {
-                auto& v = dynamic_cast<const IfStmtAST&>(ast);
-                Out() << "if (" << std::to_string(v.GetIfCond()) << ")" << std::endl;
 
-                Out() << "{" << std::endl;
-                ++_indent;
-                v.GetIFStmt()->Accept(*this);
-                --_indent;
-                Out() << "}" << std::endl;
+            Out() << "default:" << std::endl;
+            ++_indent;
+            Body(*stmt);
+            --_indent;
+        }
+        Out() << "}" << std::endl;
+    }
 
-                if (nullptr != v.GetElseStmt())
-                {
-                    Out() << "else" << std::endl;
-                    Out() << "{" << std::endl;
-                    ++_indent;
-                    v.GetElseStmt()->Accept(*this);
-                    --_indent;
-                    Out() << "}" << std::endl;
-                }
-                return false;
-            }
+    void DumpVisitor::VisitLabeledStmt(const LabeledStmtAST& ast)
+    {
+        Out() << "cast " << ast.GetInt() << ":" << std::endl;
+        ++_indent;
+        Body(*ast.GetStmt());
+        --_indent;
+    }
 
-        case ASTType::SwitchStmt:
-            {
-                auto& v = dynamic_cast<const SwitchStmtAST&>(ast);
-                Out() << "switch (" << std::to_string(v.GetExpr()) << ")" << std::endl;
-                Out() << "{" << std::endl;
-                for (const auto& stmt : v.GetStmts())
-                {
-                    if (stmt->GetASTType() == ASTType::LabeledStmt)
-                    {
-                        stmt->Accept(*this);
-                        continue;
-                    }
+    void DumpVisitor::VisitWhileStmt(const WhileStmtAST& ast)
+    {
+        Out() << "while (" << std::to_string(ast.GetCond()) << ")" << std::endl;
+        Body(*ast.GetStmt());
+    }
 
-                    Out() << "default:" << std::endl;
-                    ++_indent;
-                    Out() << "{" << std::endl;
-                    ++_indent;
-                    stmt->Accept(*this);
-                    --_indent;
-                    Out() << "}" << std::endl;
-                    --_indent;
-                }
-                Out() << "}" << std::endl;
-                return false;
-            }
-        case ASTType::LabeledStmt:
-            {
-                auto& v = dynamic_cast<const LabeledStmtAST&>(ast);
-                Out() << "cast " << v.GetInt() << ":" << std::endl;
-                ++_indent;
-                Out() << "{" << std::endl;
-                ++_indent;
-                v.GetStmt()->Accept(*this);
-                --_indent;
-                Out() << "}" << std::endl;
-                --_indent;
-                return false;
-            }
-            return false;
-        case ASTType::WhileStmt:
-            {
-                auto& v = dynamic_cast<const WhileStmtAST&>(ast);
-                Out() << "while (" << std::to_string(v.GetCond()) << ")" << std::endl;
-                Out() << "{" << std::endl;
-                ++_indent;
-                v.GetStmt()->Accept(*this);
-                --_indent;
-                Out() << "}" << std::endl;
-                return false;
-            }
-        case ASTType::DoStmt:
-            {
-                auto& v = dynamic_cast<const DoStmtAST&>(ast);
-                Out() << "do" << std::endl;
-                Out() << "{" << std::endl;
-                ++_indent;
-                v.GetStmt()->Accept(*this);
-                --_indent;
-                Out() << "}" << std::endl;
-                Out() << "while (" << std::to_string(v.GetCond()) << ");" << std::endl;
-                return false;
-            }
-        case ASTType::ForStmt:
-            {
-                auto& v = dynamic_cast<const ForStmtAST&>(ast);
-                Out() << "for (";
-                {
-                    bool isFirst = true;
-                    for (const auto& expr : v.GetInitExprs())
-                    {
-                        if (!isFirst)
-                            _stream << ", ";
-                        _stream << expr->ToString();
-                        isFirst = false;
-                    }
-                }
-                _stream << "; " << v.GetCond()->ToString() << "; ";
-                {
-                    bool isFirst = true;
-                    for (const auto& expr : v.GetUpdateExprs())
-                    {
-                        if (!isFirst)
-                            _stream << ", ";
-                        _stream << expr->ToString();
-                        isFirst = false;
-                    }
-                }
-                _stream << ")" << std::endl;
+    void DumpVisitor::VisitDoStmt(const DoStmtAST& ast)
+    {
+        Out() << "do" << std::endl;
+        Body(*ast.GetStmt());
+        Out() << "while (" << std::to_string(ast.GetCond()) << ");" << std::endl;
+    }
 
-                Out() << "{" << std::endl;
-                ++_indent;
-                v.GetBody()->Accept(*this);
-                --_indent;
-                Out() << "}" << std::endl;
-                return false;
+    void DumpVisitor::VisitForStmt(const ForStmtAST& ast)
+    {
+        Out() << "for (";
+        {
+            bool isFirst = true;
+            for (const auto& expr : ast.GetInitExprs())
+            {
+                if (!isFirst)
+                    _stream << ", ";
+                _stream << expr->ToString();
+                isFirst = false;
             }
-        case ASTType::BreakStmt:
-        case ASTType::ContinueStmt:
-        case ASTType::ReturnStmt:
-            Out() << ast.ToString() << std::endl;
-            return false;
-        case ASTType::VarDecl:
-            Out() << ast.ToString() << ";" << std::endl;
-            return false;
-        case ASTType::FuncDecl:
+        }
+        _stream << "; " << ast.GetCond()->ToString() << "; ";
+        {
+            bool isFirst = true;
+            for (const auto& expr : ast.GetUpdateExprs())
             {
-                _stream << std::endl;
-                auto& v = dynamic_cast<const FuncDeclAST&>(ast);
-                Out() << std::to_string(v.GetVarType()) << " " << v.GetName() << "(";
-                auto params = v.GetParams();
-                for (size_t i = 0, N = params.size(); i < N; ++i)
-                {
-                    if (i > 0)
-                        _stream << ", ";
-                    _stream << params[i]->ToString();
-                }
-                Out() << ")" << std::endl;
-
-
-                Out() << "{" << std::endl;
-                ++_indent;
-                v.GetBlockStmt()->Accept(*this);
-                --_indent;
-                Out() << "}" << std::endl;
-                return false;
+                if (!isFirst)
+                    _stream << ", ";
+                _stream << expr->ToString();
+                isFirst = false;
             }
-        case ASTType::File:
-            break;
-        default:
-            break;
         }
-        return true;
+        _stream << ")" << std::endl;
+
+        Body(*ast.GetBody());
     }
 
-    bool DumpVisitor::EndVisit(const AST& ast)
+    void DumpVisitor::VisitFuncDecl(const FuncDeclAST& ast)
     {
-        switch (ast.GetASTType())
+        _stream << std::endl;
+        Out() << std::to_string(ast.GetVarType()) << " " << ast.GetName() << "(";
+        const auto& params = ast.GetParams();
+        for (size_t i = 0, N = params.size(); i < N; ++i)
         {
-        case ASTType::BinaryExpr:
-        case ASTType::CastExpr:
-        case ASTType::UnaryExpr:
-        case ASTType::BraceExpr:
-        case ASTType::IdentExpr:
-        case ASTType::IntExpr:
-        case ASTType::AssignExpr:
-        case ASTType::FuncCallExpr:
-        case ASTType::EmptyStmt:
-        case ASTType::BlockStmt:
-        case ASTType::PrintStmt:
-        case ASTType::ScanStmt:
-        case ASTType::AssignStmt:
-        case ASTType::FuncCallStmt:
-        case ASTType::IfStmt:
-        case ASTType::SwitchStmt:
-        case ASTType::LabeledStmt:
-        case ASTType::WhileStmt:
-        case ASTType::DoStmt:
-        case ASTType::ForStmt:
-        case ASTType::BreakStmt:
-        case ASTType::ContinueStmt:
-        case ASTType::ReturnStmt:
-        case ASTType::VarDecl:
-        case ASTType::FuncDecl:
-        case ASTType::File:
-        default:
-            break;
+            if (i > 0)
+                _stream << ", ";
+            _stream << params[i]->ToString();
         }
-        return true;
+        Out() << ")" << std::endl;
+
+        Body(*ast.GetBlockStmt());
+    }
+
+    void DumpVisitor::Body(const AST& stmt)
+    {
+        Out() << "{" << std::endl;
+        ++_indent;
+        Visit(stmt);
+        --_indent;
+        Out() << "}" << std::endl;
     }
 
     str_t DumpVisitor::GetIndent() const
@@ -243,4 +127,4 @@ namespace c0
     {
         return _stream << GetIndent();
     }
-}
\ No newline at end of file
+}
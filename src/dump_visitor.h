@@ -1,17 +1,59 @@
 #pragma once
-#include "ast.h"
+#include "ast_visitor.h"
+#include <ostream>
 
 namespace c0
 {
-    class DumpVisitor : public ASTVisitor
+    /*
+    prints the tree as indented source. the walk is a StaticASTVisitor, the
+    ASTVisitor overrides only hand the node to it, so ast->Accept(visitor)
+    and visitor.Visit(*ast) print the same.
+    */
+    class DumpVisitor : public ASTVisitor, public StaticASTVisitor<DumpVisitor>
     {
     public:
         DumpVisitor(std::ostream& stream) : _stream(stream) {}
 
-        bool BegVisit(const AST& ast) override;
-        bool EndVisit(const AST& ast) override;
+        bool BegVisit(const AST& ast) override
+        {
+            Visit(ast);
+            return false;
+        }
+        bool EndVisit(const AST&) override { return true; }
+
+        void VisitBinaryExpr(const BinaryExprAST& ast) { Line(ast); }
+        void VisitCastExpr(const CastExprAST& ast) { Line(ast); }
+        void VisitUnaryExpr(const UnaryExprAST& ast) { Line(ast); }
+        void VisitBraceExpr(const BraceExprAST& ast) { Line(ast); }
+        void VisitIdentExpr(const IdentExprAST& ast) { Line(ast); }
+        void VisitIntExpr(const IntExprAST& ast) { Line(ast); }
+        void VisitAssignExpr(const AssignExprAST& ast) { Line(ast); }
+        void VisitFuncCallExpr(const FuncCallExprAST& ast) { Line(ast); }
+
+        void VisitEmptyStmt(const EmptyStmtAST& ast) { Out() << ast.ToString() << std::endl; }
+        void VisitPrintStmt(const PrintStmtAST& ast) { Out() << ast.ToString() << std::endl; }
+        void VisitScanStmt(const ScanStmtAST& ast) { Out() << ast.ToString() << std::endl; }
+        void VisitAssignStmt(const AssignStmtAST& ast);
+        void VisitFuncCallStmt(const FuncCallStmtAST& ast) { Out() << ast.ToString() << std::endl; }
+        void VisitIfStmt(const IfStmtAST& ast);
+        void VisitSwitchStmt(const SwitchStmtAST& ast);
+        void VisitLabeledStmt(const LabeledStmtAST& ast);
+        void VisitWhileStmt(const WhileStmtAST& ast);
+        void VisitDoStmt(const DoStmtAST& ast);
+        void VisitForStmt(const ForStmtAST& ast);
+        void VisitBreakStmt(const BreakStmtAST& ast) { Out() << ast.ToString() << std::endl; }
+        void VisitContinueStmt(const ContinueStmtAST& ast) { Out() << ast.ToString() << std::endl; }
+        void VisitReturnStmt(const ReturnStmtAST& ast) { Out() << ast.ToString() << std::endl; }
+
+        void VisitVarDecl(const VarDeclAST& ast) { Out() << ast.ToString() << ";" << std::endl; }
+        void VisitFuncDecl(const FuncDeclAST& ast);
 
     private:
+        // expression on a line of its own, not indented
+        void Line(const AST& ast) { _stream << ast.ToString() << std::endl; }
+        // stmt as the body of a compound statement, in braces one level deeper
+        void Body(const AST& stmt);
+
         str_t GetIndent() const;
         std::ostream& Out() const;
 
@@ -19,4 +61,4 @@ namespace c0
         std::ostream& _stream;
         int _indent = 0;
     };
-}
\ No newline at end of file
+}
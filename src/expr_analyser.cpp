@@ -6,9 +6,9 @@ namespace c0
     <expression> ::=
         <additive-expression>
     */
-    ExprASTPtr Analyser::AnalyseExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst)
+    ExprASTPtr Analyser::AnalyseExpr(ASTPtr parent, AnalyseError& err)
     {
-        return AnalyseAddExpr(parent, err, isNeedConst);
+        return AnalyseAddExpr(parent, err);
     }
 
     /*
@@ -18,11 +18,12 @@ namespace c0
     */
     BinaryExprASTPtr Analyser::AnalyseCondExpr(ASTPtr parent, AnalyseError& err)
     {
-        auto left = AnalyseExpr(parent, err, false);
+        auto left = AnalyseExpr(parent, err);
         if (err)
             return nullptr;
 
         BinaryType bt = BinaryType::Nul;
+        const auto opPos = _cur;
         auto token = ReadToken();
         switch (token.GetType())
         {
@@ -35,9 +36,10 @@ namespace c0
         }
 
         ExprASTPtr right;
+        auto isExplicit = true;
         if (BinaryType::Nul != bt)
         {
-            right = AnalyseExpr(parent, err, false);
+            right = AnalyseExpr(parent, err);
             if (err)
                 return nullptr;
         }
@@ -46,21 +48,11 @@ namespace c0
             UnreadToken();
 
             bt = BinaryType::NotEqual;
-            if (left->GetVarType() != VarType::Float)
-                right = std::make_shared<IntExprAST>(parent, 0);
-            else
-                right = std::make_shared<FloatExprAST>(parent, 0.0);
+            isExplicit = false;
+            right = NewAST<IntExprAST>(opPos, parent, 0);
         }
 
-        const auto varType = MergeVarType(left->GetVarType(), right->GetVarType());
-        left = CheckInexplicitTypeCast(parent, err, token, left, varType, "");
-        if (err)
-            return nullptr;
-        right = CheckInexplicitTypeCast(parent, err, token, right, varType, "");
-        if (err)
-            return nullptr;
-
-        auto expr = std::make_shared<BinaryExprAST>(parent, left, bt, right);
+        auto expr = NewAST<BinaryExprAST>(opPos, parent, left, bt, right, isExplicit);
         left->SetParent(expr);
         right->SetParent(expr);
         return expr;
@@ -70,9 +62,9 @@ namespace c0
     <additive-expression> ::=
         <multiplicative-expression>{<additive-operator><multiplicative-expression>}
     */
-    ExprASTPtr Analyser::AnalyseAddExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst)
+    ExprASTPtr Analyser::AnalyseAddExpr(ASTPtr parent, AnalyseError& err)
     {
-        auto left = AnalyseMulExpr(parent, err, isNeedConst);
+        auto left = AnalyseMulExpr(parent, err);
         if (err)
             return nullptr;
 
@@ -80,22 +72,15 @@ namespace c0
             token.GetType() == TokenType::S_PLUS || token.GetType() == TokenType::S_MINUS;
             token = PeekToken())
         {
+            const auto opPos = _cur;
             ReadToken();
             const auto bt = (token.GetType() == TokenType::S_PLUS ? BinaryType::Add : BinaryType::Sub);
 
-            auto right = AnalyseMulExpr(parent, err, isNeedConst);
-            if (err)
-                return nullptr;
-
-            const auto varType = MergeVarType(left->GetVarType(), right->GetVarType());
-            left = CheckInexplicitTypeCast(parent, err, token, left, varType, "");
-            if (err)
-                return nullptr;
-            right = CheckInexplicitTypeCast(parent, err, token, right, varType, "");
+            auto right = AnalyseMulExpr(parent, err);
             if (err)
                 return nullptr;
 
-            auto expr = std::make_shared<BinaryExprAST>(parent, left, bt, right);
+            auto expr = NewAST<BinaryExprAST>(opPos, parent, left, bt, right);
             expr->GetLeftExpr()->SetParent(expr);
             expr->GetRightExpr()->SetParent(expr);
             left = expr;
@@ -108,9 +93,9 @@ namespace c0
     <multiplicative-expression> ::=
         <cast-expression>{<multiplicative-operator><cast-expression>}
     */
-    ExprASTPtr Analyser::AnalyseMulExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst)
+    ExprASTPtr Analyser::AnalyseMulExpr(ASTPtr parent, AnalyseError& err)
     {
-        auto left = AnalyseCastExpr(parent, err, isNeedConst);
+        auto left = AnalyseCastExpr(parent, err);
         if (err)
             return nullptr;
 
@@ -118,22 +103,15 @@ namespace c0
             token.GetType() == TokenType::S_MUL || token.GetType() == TokenType::S_DIV;
             token = PeekToken())
         {
+            const auto opPos = _cur;
             ReadToken();
             const auto bt = (token.GetType() == TokenType::S_MUL ? BinaryType::Mul : BinaryType::Div);
 
-            auto right = AnalyseCastExpr(parent, err, isNeedConst);
-            if (err)
-                return nullptr;
-
-            const auto varType = MergeVarType(left->GetVarType(), right->GetVarType());
-            left = CheckInexplicitTypeCast(parent, err, token, left, varType, "");
-            if (err)
-                return nullptr;
-            right = CheckInexplicitTypeCast(parent, err, token, right, varType, "");
+            auto right = AnalyseCastExpr(parent, err);
             if (err)
                 return nullptr;
 
-            auto expr = std::make_shared<BinaryExprAST>(parent, left, bt, right);
+            auto expr = NewAST<BinaryExprAST>(opPos, parent, left, bt, right);
             expr->GetLeftExpr()->SetParent(expr);
             expr->GetRightExpr()->SetParent(expr);
             left = expr;
@@ -146,9 +124,10 @@ namespace c0
     <cast-expression> ::=
         {'('<type-specifier>')'}<unary-expression>
     */
-    ExprASTPtr Analyser::AnalyseCastExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst)
+    ExprASTPtr Analyser::AnalyseCastExpr(ASTPtr parent, AnalyseError& err)
     {
         VarType varType = VarType::Nul;
+        const auto castPos = _cur;
         auto token = PeekToken();
         if (token.GetType() == TokenType::S_LBRACES)
         {
@@ -167,25 +146,15 @@ namespace c0
             }
         }
 
-        auto expr = AnalyseUnaryExpr(parent, err, isNeedConst);
+        auto expr = AnalyseUnaryExpr(parent, err);
         if (err)
             return nullptr;
 
-        if (VarType::Nul != varType)
+        if (IsValidCastType(varType))
         {
-            if (!IsVarTypeCastable(expr->GetVarType(), varType))
-            {
-                err = AnalyseError("can not cast type from '"
-                    + std::to_string(expr->GetVarType()) + "' to '"
-                    + std::to_string(varType) + "'", token);
-                return nullptr;
-            }
-            if (IsValidCastType(varType))
-            {
-                auto cast = std::make_shared<CastExprAST>(parent, expr, varType, true);
-                cast->GetExpr()->SetParent(cast);
-                expr = cast;
-            }
+            auto cast = NewAST<CastExprAST>(castPos, parent, expr, varType, true);
+            cast->GetExpr()->SetParent(cast);
+            expr = cast;
         }
         return expr;
     }
@@ -194,29 +163,24 @@ namespace c0
     <unary-expression> ::=
         [<unary-operator>]<primary-expression>
     */
-    ExprASTPtr Analyser::AnalyseUnaryExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst)
+    ExprASTPtr Analyser::AnalyseUnaryExpr(ASTPtr parent, AnalyseError& err)
     {
         auto token = PeekToken();
         if (token.GetType() == TokenType::S_PLUS || token.GetType() == TokenType::S_MINUS)
         {
+            const auto opPos = _cur;
             ReadToken();
             const auto ut = (token.GetType() == TokenType::S_PLUS ? UnaryType::Positive : UnaryType::Negative);
 
-            auto expr = AnalysePrimaryExpr(parent, err, isNeedConst);
+            auto expr = AnalysePrimaryExpr(parent, err);
             if (err)
                 return nullptr;
 
-            if (expr->GetVarType() == VarType::Str)
-            {
-                err = AnalyseError("cannot apply unary operator on string", token);
-                return nullptr;
-            }
-
-            auto tmp = std::make_shared<UnaryExprAST>(parent, ut, expr);
+            auto tmp = NewAST<UnaryExprAST>(opPos, parent, ut, expr);
             tmp->GetExpr()->SetParent(tmp);
             return tmp;
         }
-        return AnalysePrimaryExpr(parent, err, isNeedConst);
+        return AnalysePrimaryExpr(parent, err);
     }
     
     /*
@@ -228,64 +192,49 @@ namespace c0
         |<floating-literal>
         |<function-call>
     */
-    ExprASTPtr Analyser::AnalysePrimaryExpr(ASTPtr parent, AnalyseError& err, bool isNeedConst)
+    ExprASTPtr Analyser::AnalysePrimaryExpr(ASTPtr parent, AnalyseError& err)
     {
+        const auto pos = _cur;
         auto token = ReadToken();
         if (token.GetType() == TokenType::S_LBRACES)
         {
-            auto expr = AnalyseExpr(parent, err, isNeedConst);
+            auto expr = AnalyseExpr(parent, err);
+            if (err)
+                return nullptr;
             token = ReadToken();
             if (token.GetType() != TokenType::S_RBRACES)
             {
                 err = AnalyseError("expect ')' after expression", token);
                 return nullptr;
             }
-            auto tmp = std::make_shared<BraceExprAST>(parent, expr);
+            auto tmp = NewAST<BraceExprAST>(pos, parent, expr);
             tmp->GetExpr()->SetParent(tmp);
             return tmp;
         }
         else if (token.GetType() == TokenType::INT)
         {
-            return std::make_shared<IntExprAST>(parent, token.GetInt());
+            return NewAST<IntExprAST>(pos, parent, token.GetInt());
         }
         else if (token.GetType() == TokenType::CHAR)
         {
-            return std::make_shared<CharExprAST>(parent, token.GetChar());
+            return NewAST<CharExprAST>(pos, parent, token.GetChar());
         }
         else if (token.GetType() == TokenType::FLOAT)
         {
-            return std::make_shared<FloatExprAST>(parent, token.GetFloat());
+            return NewAST<FloatExprAST>(pos, parent, token.GetFloat());
         }
         else if (token.GetType() == TokenType::STR)
         {
-            return std::make_shared<StrExprAST>(parent, token.GetString());
+            return NewAST<StrExprAST>(pos, parent, token.GetString());
         }
         else if (token.GetType() == TokenType::IDENT)
         {
-            const auto t = parent->GetSymbolType(token.GetString(), true);
-            if (t == SymbolType::Var || t == SymbolType::ConstVar)
-            {
-                if (isNeedConst && t != SymbolType::ConstVar)
-                {
-                    err = AnalyseError("expect const variable", token);
-                    return nullptr;
-                }
-                return std::make_shared<IdentExprAST>(parent, token.GetString());
-            }
-            else if (t == SymbolType::Func)
+            if (GetIdentLookahead(PeekToken().GetType()) == Lookahead::FuncCall)
             {
-                if (isNeedConst)
-                {
-                    err = AnalyseError("expect const express but got function call", token);
-                    return nullptr;
-                }
-
                 UnreadToken();
-                return AnalyseFuncCallExpr(parent, err, true);
+                return AnalyseFuncCallExpr(parent, err);
             }
-
-            err = AnalyseError("unknown identifier in primary expression", token);
-            return nullptr;
+            return NewAST<IdentExprAST>(pos, parent, token.GetString());
         }
 
         err = AnalyseError("expect primary expression", token);
@@ -299,6 +248,7 @@ namespace c0
     */
     AssignExprASTPtr Analyser::AnalyseAssignExpr(ASTPtr parent, AnalyseError& err)
     {
+        const auto namePos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::IDENT)
         {
@@ -306,17 +256,6 @@ namespace c0
             return nullptr;
         }
         const auto varName = token.GetString();
-        auto vardecl = std::dynamic_pointer_cast<VarDeclAST>(parent->GetSymbol(varName, true));
-        if (nullptr == vardecl)
-        {
-            err = AnalyseError("cannot find variable in assignment expression", token);
-            return nullptr;
-        }
-        if (vardecl->IsConst())
-        {
-            err = AnalyseError("cannot assign on const variable in assignment expression", token);
-            return nullptr;
-        }
 
         token = ReadToken();
         if (token.GetType() != TokenType::S_ASSIGN)
@@ -325,16 +264,11 @@ namespace c0
             return nullptr;
         }
 
-        auto expr = AnalyseExpr(parent, err, false);
+        auto expr = AnalyseExpr(parent, err);
         if (err)
             return nullptr;
 
-        expr = CheckInexplicitTypeCast(parent, err, token, expr, vardecl->GetVarType(), 
-            "invalid assignment expression, ");
-        if (err)
-            return nullptr;
-
-        auto tmp = std::make_shared<AssignExprAST>(parent, varName, expr);
+        auto tmp = NewAST<AssignExprAST>(namePos, parent, varName, expr);
         tmp->GetExpr()->SetParent(tmp);
         return tmp;
     }
@@ -345,27 +279,16 @@ namespace c0
     <expression-list> ::= 
         <expression>{','<expression>}
     */
-    ExprASTPtr Analyser::AnalyseFuncCallExpr(ASTPtr parent, AnalyseError& err, bool isNeedReturn)
+    FuncCallExprASTPtr Analyser::AnalyseFuncCallExpr(ASTPtr parent, AnalyseError& err)
     {
+        const auto namePos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::IDENT)
         {
             err = AnalyseError("expect function name in function call expression", token);
             return nullptr;
         }
-
         const auto funcName = token.GetString();
-        const auto funcimpl = std::dynamic_pointer_cast<FuncDeclAST>(parent->GetSymbol(funcName, true));
-        if (nullptr == funcimpl)
-        {
-            err = AnalyseError("identifier is not a function name in function call expression", token);
-            return nullptr;
-        }
-        if (isNeedReturn && funcimpl->GetVarType() == VarType::Void)
-        {
-            err = AnalyseError("function has no return in function call expression", token);
-            return nullptr;
-        }
 
         token = ReadToken();
         if (token.GetType() != TokenType::S_LBRACES)
@@ -374,41 +297,22 @@ namespace c0
             return nullptr;
         }
 
-        auto funccall = std::make_shared<FuncCallExprAST>(parent, funcName);
-        ExprASTPtrList callParams;
+        auto funccall = NewAST<FuncCallExprAST>(namePos, parent, funcName);
 
         for (token = PeekToken();
             token.GetType() != TokenType::S_RBRACES;
             token = PeekToken())
         {
-            auto param = AnalyseExpr(funccall, err, false);
+            auto param = AnalyseExpr(funccall, err);
             if (err)
                 return nullptr;
-            callParams.push_back(param);
+            funccall->AddParam(param);
             
             token = PeekToken();
             if (token.GetType() == TokenType::S_COMMA)
                 ReadToken();
         }
 
-        const auto& declParams = funcimpl->GetParams();
-        if (callParams.size() != declParams.size())
-        {
-            err = AnalyseError("parameter number mismatch in function call expression, need " 
-                + std::to_string(declParams.size())
-                + ", have " + std::to_string(callParams.size())
-                , token);
-            return nullptr;
-        }
-        for (size_t i = 0, N = callParams.size(); i < N; ++i)
-        {
-            auto param = CheckInexplicitTypeCast(funccall, err, token, callParams[i], declParams[i]->GetVarType(),
-                "for " + std::to_string(i) + "th function param in function call expression, ");
-            if (err)
-                return nullptr;
-            funccall->AddParam(param);
-        }
-
         token = ReadToken();
         if (token.GetType() != TokenType::S_RBRACES)
         {
@@ -418,4 +322,4 @@ namespace c0
 
         return funccall;
     }
-}
+}
\ No newline at end of file
@@ -18,7 +18,7 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType BinaryExprAST::GetVarType() const
+    VarType BinaryExprAST::ResolveVarType() const
     {
         const auto leftVT = _left->GetVarType();
         const auto rightVT = _right->GetVarType();
@@ -31,7 +31,7 @@ namespace c0
 #if 0
             std::string(_isExplicit ? "" : "/*inexplicit cast*/") + 
 #endif
-            "(" + std::to_string(_type) + ")(" + _expr->ToString() + ")";
+            "(" + std::to_string(GetVarType()) + ")(" + _expr->ToString() + ")";
     }
 
     bool CastExprAST::Accept(ASTVisitor& visitor) const
@@ -41,11 +41,6 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType CastExprAST::GetVarType() const
-    {
-        return _type;
-    }
-
     std::string UnaryExprAST::ToString() const
     {
         return std::to_string(_ut) + _expr->ToString();
@@ -58,7 +53,7 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType UnaryExprAST::GetVarType() const
+    VarType UnaryExprAST::ResolveVarType() const
     {
         return _expr->GetVarType();
     }
@@ -98,7 +93,7 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType BraceExprAST::GetVarType() const
+    VarType BraceExprAST::ResolveVarType() const
     {
         return _expr->GetVarType();
     }
@@ -114,9 +109,9 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType IdentExprAST::GetVarType() const
+    VarType IdentExprAST::ResolveVarType() const
     {
-        const auto decl = std::dynamic_pointer_cast<DeclAST>(GetSymbol(_name, true));
+        const auto decl = nullptr != _decl ? _decl : dynamic_cast<DeclASTPtr>(GetSymbol(_name, true));
         if (nullptr != decl)
             return decl->GetVarType();
         return VarType::Nul;
@@ -133,11 +128,6 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType IntExprAST::GetVarType() const
-    {
-        return VarType::Int;
-    }
-
     std::string CharExprAST::ToString() const
     {
         return Token(_char, posrange_t()).GetValueString();
@@ -149,11 +139,6 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType CharExprAST::GetVarType() const
-    {
-        return VarType::Char;
-    }
-
     std::string FloatExprAST::ToString() const
     {
         return std::to_string(_float);
@@ -165,11 +150,6 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType FloatExprAST::GetVarType() const
-    {
-        return VarType::Float;
-    }
-
     std::string StrExprAST::ToString() const
     {
         return "\"" + _str + "\"";
@@ -181,11 +161,6 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType StrExprAST::GetVarType() const
-    {
-        return VarType::Str;
-    }
-
     std::string AssignExprAST::ToString() const
     {
         return _name + " = " + _expr->ToString();
@@ -198,9 +173,9 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType AssignExprAST::GetVarType() const
+    VarType AssignExprAST::ResolveVarType() const
     {
-        const auto decl = std::dynamic_pointer_cast<DeclAST>(GetSymbol(_name, true));
+        const auto decl = nullptr != _decl ? _decl : dynamic_cast<DeclASTPtr>(GetSymbol(_name, true));
         if (nullptr != decl)
             return decl->GetVarType();
         return VarType::Nul;
@@ -228,9 +203,9 @@ namespace c0
         return visitor.EndVisit(*this);
     }
 
-    VarType FuncCallExprAST::GetVarType() const
+    VarType FuncCallExprAST::ResolveVarType() const
     {
-        const auto decl = std::dynamic_pointer_cast<DeclAST>(GetSymbol(_name, true));
+        const auto decl = nullptr != _decl ? _decl : dynamic_cast<DeclASTPtr>(GetSymbol(_name, true));
         if (nullptr != decl)
             return decl->GetVarType();
         return VarType::Nul;
@@ -6,39 +6,61 @@ namespace c0
     class ExprAST : public AST
     {
     public:
-        ExprAST(ASTPtr parent, ASTType type) : AST(parent, type) {}
+        ExprAST(ASTPtr parent, ASTType type, VarType varType = VarType::Nul)
+            : AST(parent, type)
+            , _varType(varType)
+        {}
 
-        virtual VarType GetVarType() const = 0;
+        /*
+        type is fixed at construction for literals and casts, and set by
+        semantic analyse for the others, an expression not analysed yet
+        resolves its type on each call.
+        */
+        VarType GetVarType() const { return VarType::Nul != _varType ? _varType : ResolveVarType(); }
+        void SetVarType(VarType type) { _varType = type; }
 
         virtual bool IsConst() const { return false; }
         virtual int_t GetInt() const { return 0; }
         virtual char_t GetChar() const { return 0; }
         virtual float_t GetFloat() const { return 0.0; }
+
+    protected:
+        virtual VarType ResolveVarType() const { return VarType::Nul; }
+
+    private:
+        VarType _varType;
     };
 
     class BinaryExprAST : public ExprAST
     {
     public:
-        BinaryExprAST(ASTPtr parent, ExprASTPtr left, BinaryType ot, ExprASTPtr right)
+        BinaryExprAST(ASTPtr parent, ExprASTPtr left, BinaryType ot, ExprASTPtr right, bool isExplicit = true)
             : ExprAST(parent, ASTType::BinaryExpr)
-            , _left(left)
             , _ot(ot)
+            , _isExplicit(isExplicit)
+            , _left(left)
             , _right(right)
         {}
 
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         bool IsCond() const { return _ot >= BinaryType::Less && _ot <= BinaryType::GreaterEqual; }
+        bool IsExplicit() const { return _isExplicit; }
         const ExprASTPtr& GetLeftExpr() const { return _left; }
         BinaryType GetOT() const { return _ot; }
         const ExprASTPtr& GetRightExpr() const { return _right; }
 
+        void SetLeftExpr(ExprASTPtr ptr) { _left = ptr; }
+        void SetRightExpr(ExprASTPtr ptr) { _right = ptr; }
+
+    protected:
+        VarType ResolveVarType() const override;
+
     private:
-        ExprASTPtr _left;
         BinaryType _ot;
+        bool _isExplicit;   // false for condition without relational operator
+        ExprASTPtr _left;
         ExprASTPtr _right;
     };
 
@@ -46,25 +68,21 @@ namespace c0
     {
     public:
         CastExprAST(ASTPtr parent, ExprASTPtr expr, VarType type, bool isExplicit)
-            : ExprAST(parent, ASTType::CastExpr)
-            , _expr(expr)
-            , _type(type)
+            : ExprAST(parent, ASTType::CastExpr, type)
             , _isExplicit(isExplicit)
+            , _expr(expr)
         {
         }
 
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         const ExprASTPtr& GetExpr() const { return _expr; }
         bool IsExplicit() const { return _isExplicit; }
 
     private:
-        ExprASTPtr _expr;
-        VarType _type;
         bool _isExplicit;
+        ExprASTPtr _expr;
     };
 
     class UnaryExprAST : public ExprAST
@@ -79,8 +97,6 @@ namespace c0
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         bool IsConst() const override;
         int_t GetInt() const override;
         char_t GetChar() const override;
@@ -89,6 +105,9 @@ namespace c0
         UnaryType GetUT() const { return _ut; }
         const ExprASTPtr& GetExpr() const { return _expr; }
 
+    protected:
+        VarType ResolveVarType() const override;
+
     private:
         UnaryType _ut;
         ExprASTPtr _expr;
@@ -97,7 +116,7 @@ namespace c0
     class PrimaryExprAST : public ExprAST
     {
     public:
-        PrimaryExprAST(ASTPtr parent, ASTType type) : ExprAST(parent, type) {}
+        PrimaryExprAST(ASTPtr parent, ASTType type, VarType varType = VarType::Nul) : ExprAST(parent, type, varType) {}
     };
 
     class BraceExprAST : public PrimaryExprAST
@@ -111,10 +130,11 @@ namespace c0
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         const ExprASTPtr& GetExpr() const { return _expr; }
 
+    protected:
+        VarType ResolveVarType() const override;
+
     private:
         ExprASTPtr _expr;
     };
@@ -127,24 +147,26 @@ namespace c0
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         const str_t& GetName() const { return _name; }
+        DeclASTPtr GetDecl() const { return _decl; }
+        void SetDecl(DeclASTPtr decl) { _decl = decl; }
+
+    protected:
+        VarType ResolveVarType() const override;
 
     private:
         str_t _name;
+        DeclASTPtr _decl = nullptr;   // resolved by semantic analyse
     };
 
     class IntExprAST : public PrimaryExprAST
     {
     public:
-        IntExprAST(ASTPtr parent, int_t i) : PrimaryExprAST(parent, ASTType::IntExpr), _int(i) {}
+        IntExprAST(ASTPtr parent, int_t i) : PrimaryExprAST(parent, ASTType::IntExpr, VarType::Int), _int(i) {}
 
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         bool IsConst() const override { return true; }
         int_t GetInt() const override { return _int; }
 
@@ -155,13 +177,11 @@ namespace c0
     class CharExprAST : public PrimaryExprAST
     {
     public:
-        CharExprAST(ASTPtr parent, char_t c) : PrimaryExprAST(parent, ASTType::CharExpr), _char(c) {}
+        CharExprAST(ASTPtr parent, char_t c) : PrimaryExprAST(parent, ASTType::CharExpr, VarType::Char), _char(c) {}
 
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         bool IsConst() const override { return true; }
         char_t GetChar() const override { return _char; }
 
@@ -172,13 +192,11 @@ namespace c0
     class FloatExprAST : public PrimaryExprAST
     {
     public:
-        FloatExprAST(ASTPtr parent, float_t f) : PrimaryExprAST(parent, ASTType::FloatExpr), _float(f) {}
+        FloatExprAST(ASTPtr parent, float_t f) : PrimaryExprAST(parent, ASTType::FloatExpr, VarType::Float), _float(f) {}
 
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         bool IsConst() const override { return true; }
         float_t GetFloat() const override { return _float; }
 
@@ -189,13 +207,11 @@ namespace c0
     class StrExprAST : public PrimaryExprAST
     {
     public:
-        StrExprAST(ASTPtr parent, const str_t& str) : PrimaryExprAST(parent, ASTType::StrExpr), _str(str) {}
+        StrExprAST(ASTPtr parent, const str_t& str) : PrimaryExprAST(parent, ASTType::StrExpr, VarType::Str), _str(str) {}
 
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         const str_t& GetStr() const { return _str; }
 
     private:
@@ -214,13 +230,18 @@ namespace c0
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         const str_t& GetName() const { return _name; }
+        DeclASTPtr GetDecl() const { return _decl; }
+        void SetDecl(DeclASTPtr decl) { _decl = decl; }
         const ExprASTPtr& GetExpr() const { return _expr; }
+        void SetExpr(ExprASTPtr ptr) { _expr = ptr; }
+
+    protected:
+        VarType ResolveVarType() const override;
 
     private:
         str_t _name;
+        DeclASTPtr _decl = nullptr;   // resolved by semantic analyse
         ExprASTPtr _expr;
     };
 
@@ -232,15 +253,20 @@ namespace c0
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
-        VarType GetVarType() const override;
-
         void AddParam(ExprASTPtr ptr) { _params.push_back(ptr); }
+        void SetParam(std::size_t i, ExprASTPtr ptr) { _params[i] = ptr; }
 
         const str_t& GetName() const { return _name; }
+        DeclASTPtr GetDecl() const { return _decl; }
+        void SetDecl(DeclASTPtr decl) { _decl = decl; }
         const ExprASTPtrList& GetParams() const { return _params; }
 
+    protected:
+        VarType ResolveVarType() const override;
+
     private:
         str_t _name;
+        DeclASTPtr _decl = nullptr;   // resolved by semantic analyse
         ExprASTPtrList _params;
     };
 
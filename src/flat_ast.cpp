@@ -0,0 +1,481 @@
+#include "flat_ast.h"
+
+namespace c0
+{
+    FlatAST::FlatAST(const FileAST& file)
+    {
+        Flatten(file);
+        _stringIndex.clear();
+    }
+
+    std::size_t FlatAST::GetChildCount(std::size_t i) const
+    {
+        std::size_t n = 0;
+        for (auto j = GetFirstChild(i), end = GetNextSibling(i); j < end; j = GetNextSibling(j))
+            ++n;
+        return n;
+    }
+
+    std::uint32_t FlatAST::AddString(const str_t& s)
+    {
+        const auto it = _stringIndex.find(s);
+        if (it != _stringIndex.end())
+            return it->second;
+
+        const auto index = static_cast<std::uint32_t>(_strings.size());
+        _strings.push_back(s);
+        _stringIndex.emplace(s, index);
+        return index;
+    }
+
+    void FlatAST::Flatten(const AST& ast)
+    {
+        const auto i = _nodes.size();
+        FlatNode node = {};
+        node.type = static_cast<std::uint8_t>(ast.GetASTType());
+        node.token = static_cast<std::uint32_t>(ast.GetTokenIndex());
+        _nodes.push_back(node);
+
+        // _nodes may grow while children are flattened, only index i is kept
+        switch (ast.GetASTType())
+        {
+        case ASTType::BinaryExpr:
+        {
+            const auto& v = static_cast<const BinaryExprAST&>(ast);
+            _nodes[i].op = static_cast<std::uint8_t>(v.GetOT());
+            _nodes[i].flags = v.IsExplicit() ? FF_EXPLICIT : 0;
+            Flatten(*v.GetLeftExpr());
+            Flatten(*v.GetRightExpr());
+            break;
+        }
+        case ASTType::CastExpr:
+        {
+            const auto& v = static_cast<const CastExprAST&>(ast);
+            _nodes[i].op = static_cast<std::uint8_t>(v.GetVarType());
+            _nodes[i].flags = v.IsExplicit() ? FF_EXPLICIT : 0;
+            Flatten(*v.GetExpr());
+            break;
+        }
+        case ASTType::UnaryExpr:
+        {
+            const auto& v = static_cast<const UnaryExprAST&>(ast);
+            _nodes[i].op = static_cast<std::uint8_t>(v.GetUT());
+            Flatten(*v.GetExpr());
+            break;
+        }
+        case ASTType::BraceExpr:
+            Flatten(*static_cast<const BraceExprAST&>(ast).GetExpr());
+            break;
+        case ASTType::IdentExpr:
+            _nodes[i].payload = AddString(static_cast<const IdentExprAST&>(ast).GetName());
+            break;
+        case ASTType::IntExpr:
+            _nodes[i].payload = static_cast<std::uint32_t>(static_cast<const IntExprAST&>(ast).GetInt());
+            break;
+        case ASTType::CharExpr:
+            _nodes[i].payload = static_cast<std::uint32_t>(static_cast<const CharExprAST&>(ast).GetChar());
+            break;
+        case ASTType::FloatExpr:
+            _nodes[i].payload = static_cast<std::uint32_t>(_floats.size());
+            _floats.push_back(static_cast<const FloatExprAST&>(ast).GetFloat());
+            break;
+        case ASTType::StrExpr:
+            _nodes[i].payload = AddString(static_cast<const StrExprAST&>(ast).GetStr());
+            break;
+        case ASTType::AssignExpr:
+        {
+            const auto& v = static_cast<const AssignExprAST&>(ast);
+            _nodes[i].payload = AddString(v.GetName());
+            Flatten(*v.GetExpr());
+            break;
+        }
+        case ASTType::FuncCallExpr:
+        {
+            const auto& v = static_cast<const FuncCallExprAST&>(ast);
+            _nodes[i].payload = AddString(v.GetName());
+            for (const auto& param : v.GetParams())
+                Flatten(*param);
+            break;
+        }
+
+        case ASTType::BlockStmt:
+        {
+            const auto& v = static_cast<const BlockStmtAST&>(ast);
+            for (const auto& var : v.GetVars())
+                Flatten(*var);
+            for (const auto& stmt : v.GetStmts())
+                Flatten(*stmt);
+            break;
+        }
+        case ASTType::PrintStmt:
+            for (const auto& param : static_cast<const PrintStmtAST&>(ast).GetParams())
+                Flatten(*param);
+            break;
+        case ASTType::ScanStmt:
+            _nodes[i].payload = AddString(static_cast<const ScanStmtAST&>(ast).GetName());
+            break;
+        case ASTType::AssignStmt:
+        {
+            const auto& v = static_cast<const AssignStmtAST&>(ast);
+            _nodes[i].payload = AddString(v.GetName());
+            Flatten(*v.GetExpr());
+            break;
+        }
+        case ASTType::FuncCallStmt:
+        {
+            const auto& v = static_cast<const FuncCallStmtAST&>(ast);
+            _nodes[i].payload = AddString(v.GetName());
+            for (const auto& param : v.GetParams())
+                Flatten(*param);
+            break;
+        }
+        case ASTType::IfStmt:
+        {
+            const auto& v = static_cast<const IfStmtAST&>(ast);
+            Flatten(*v.GetIfCond());
+            Flatten(*v.GetIFStmt());
+            if (nullptr != v.GetElseStmt())
+                Flatten(*v.GetElseStmt());
+            break;
+        }
+        case ASTType::SwitchStmt:
+        {
+            const auto& v = static_cast<const SwitchStmtAST&>(ast);
+            Flatten(*v.GetExpr());
+            for (const auto& stmt : v.GetStmts())
+                Flatten(*stmt);
+            break;
+        }
+        case ASTType::LabeledStmt:
+        {
+            const auto& v = static_cast<const LabeledStmtAST&>(ast);
+            _nodes[i].payload = static_cast<std::uint32_t>(v.GetInt());
+            if (nullptr != v.GetStmt())
+                Flatten(*v.GetStmt());
+            break;
+        }
+        case ASTType::WhileStmt:
+        {
+            const auto& v = static_cast<const WhileStmtAST&>(ast);
+            Flatten(*v.GetCond());
+            Flatten(*v.GetStmt());
+            break;
+        }
+        case ASTType::DoStmt:
+        {
+            const auto& v = static_cast<const DoStmtAST&>(ast);
+            Flatten(*v.GetStmt());
+            Flatten(*v.GetCond());
+            break;
+        }
+        case ASTType::ForStmt:
+        {
+            const auto& v = static_cast<const ForStmtAST&>(ast);
+            _nodes[i].payload = static_cast<std::uint32_t>(v.GetInitExprs().size());
+            for (const auto& expr : v.GetInitExprs())
+                Flatten(*expr);
+            Flatten(*v.GetCond());
+            for (const auto& expr : v.GetUpdateExprs())
+                Flatten(*expr);
+            Flatten(*v.GetBody());
+            break;
+        }
+        case ASTType::ReturnStmt:
+        {
+            const auto& v = static_cast<const ReturnStmtAST&>(ast);
+            if (nullptr != v.GetExpr())
+                Flatten(*v.GetExpr());
+            break;
+        }
+
+        case ASTType::VarDecl:
+        {
+            const auto& v = static_cast<const VarDeclAST&>(ast);
+            _nodes[i].op = static_cast<std::uint8_t>(v.GetVarType());
+            _nodes[i].flags = (v.IsParam() ? FF_PARAM : 0) | (v.IsConst() ? FF_CONST : 0);
+            _nodes[i].payload = AddString(v.GetName());
+            if (v.HasExpr())
+                Flatten(*v.GetExpr());
+            break;
+        }
+        case ASTType::FuncDecl:
+        {
+            const auto& v = static_cast<const FuncDeclAST&>(ast);
+            _nodes[i].op = static_cast<std::uint8_t>(v.GetVarType());
+            _nodes[i].payload = AddString(v.GetName());
+            for (const auto& param : v.GetParams())
+                Flatten(*param);
+            if (nullptr != v.GetBlockStmt())
+                Flatten(*v.GetBlockStmt());
+            break;
+        }
+        case ASTType::File:
+        {
+            const auto& v = static_cast<const FileAST&>(ast);
+            for (const auto& var : v.GetVars())
+                Flatten(*var);
+            for (const auto& func : v.GetFuncs())
+                Flatten(*func);
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        _nodes[i].size = static_cast<std::uint32_t>(_nodes.size() - i);
+    }
+
+    FileASTPtr FlatAST::ToTree() const
+    {
+        auto file = std::make_shared<FileAST>(nullptr);
+        if (_nodes.empty())
+            return file;
+
+        auto& context = file->GetContext();
+        for (auto j = GetFirstChild(0); j < GetNextSibling(0); j = GetNextSibling(j))
+        {
+            if (_nodes[j].GetASTType() == ASTType::VarDecl)
+                file->AddVar(BuildAs<VarDeclAST>(context, file.get(), j));
+            else
+                file->AddFunc(BuildAs<FuncDeclAST>(context, file.get(), j));
+        }
+        return file;
+    }
+
+    /*
+    children are built before their parent node exists, parent of each child
+    is set after the parent is created.
+    */
+    ASTPtr FlatAST::Build(ASTContext& context, ASTPtr parent, std::size_t i) const
+    {
+        const auto& node = _nodes[i];
+        const auto end = GetNextSibling(i);
+        auto j = GetFirstChild(i);
+
+        ASTPtr ast = nullptr;
+        switch (node.GetASTType())
+        {
+        case ASTType::BinaryExpr:
+        {
+            auto left = BuildAs<ExprAST>(context, nullptr, j);
+            auto right = BuildAs<ExprAST>(context, nullptr, GetNextSibling(j));
+            auto v = context.New<BinaryExprAST>(parent, left, BinaryType(node.op), right,
+                0 != (node.flags & FF_EXPLICIT));
+            left->SetParent(v);
+            right->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::CastExpr:
+        {
+            auto expr = BuildAs<ExprAST>(context, nullptr, j);
+            auto v = context.New<CastExprAST>(parent, expr, VarType(node.op), 0 != (node.flags & FF_EXPLICIT));
+            expr->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::UnaryExpr:
+        {
+            auto expr = BuildAs<ExprAST>(context, nullptr, j);
+            auto v = context.New<UnaryExprAST>(parent, UnaryType(node.op), expr);
+            expr->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::BraceExpr:
+        {
+            auto expr = BuildAs<ExprAST>(context, nullptr, j);
+            auto v = context.New<BraceExprAST>(parent, expr);
+            expr->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::IdentExpr:
+            ast = context.New<IdentExprAST>(parent, GetString(i));
+            break;
+        case ASTType::IntExpr:
+            ast = context.New<IntExprAST>(parent, GetInt(i));
+            break;
+        case ASTType::CharExpr:
+            ast = context.New<CharExprAST>(parent, GetChar(i));
+            break;
+        case ASTType::FloatExpr:
+            ast = context.New<FloatExprAST>(parent, GetFloat(i));
+            break;
+        case ASTType::StrExpr:
+            ast = context.New<StrExprAST>(parent, GetString(i));
+            break;
+        case ASTType::AssignExpr:
+        {
+            auto expr = BuildAs<ExprAST>(context, nullptr, j);
+            auto v = context.New<AssignExprAST>(parent, GetString(i), expr);
+            expr->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::FuncCallExpr:
+        {
+            auto v = context.New<FuncCallExprAST>(parent, GetString(i));
+            for (; j < end; j = GetNextSibling(j))
+                v->AddParam(BuildAs<ExprAST>(context, v, j));
+            ast = v;
+            break;
+        }
+
+        case ASTType::EmptyStmt:
+            ast = context.New<EmptyStmtAST>(parent);
+            break;
+        case ASTType::BlockStmt:
+        {
+            auto v = context.New<BlockStmtAST>(parent);
+            for (; j < end; j = GetNextSibling(j))
+            {
+                if (_nodes[j].GetASTType() == ASTType::VarDecl)
+                    v->AddVar(BuildAs<VarDeclAST>(context, v, j));
+                else
+                    v->AddStmt(BuildAs<StmtAST>(context, v, j));
+            }
+            ast = v;
+            break;
+        }
+        case ASTType::PrintStmt:
+        {
+            auto v = context.New<PrintStmtAST>(parent);
+            for (; j < end; j = GetNextSibling(j))
+                v->AddParam(BuildAs<ExprAST>(context, v, j));
+            ast = v;
+            break;
+        }
+        case ASTType::ScanStmt:
+            ast = context.New<ScanStmtAST>(parent, GetString(i));
+            break;
+        case ASTType::AssignStmt:
+        {
+            auto expr = BuildAs<ExprAST>(context, nullptr, j);
+            auto v = context.New<AssignStmtAST>(parent, GetString(i), expr);
+            expr->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::FuncCallStmt:
+        {
+            auto v = context.New<FuncCallStmtAST>(parent, GetString(i));
+            for (; j < end; j = GetNextSibling(j))
+                v->AddParam(BuildAs<ExprAST>(context, v, j));
+            ast = v;
+            break;
+        }
+        case ASTType::IfStmt:
+        {
+            auto cond = BuildAs<BinaryExprAST>(context, nullptr, j);
+            j = GetNextSibling(j);
+            auto stmt = BuildAs<StmtAST>(context, nullptr, j);
+            j = GetNextSibling(j);
+            auto v = context.New<IfStmtAST>(parent, cond, stmt);
+            cond->SetParent(v);
+            stmt->SetParent(v);
+            if (j < end)
+                v->SetElseStmt(BuildAs<StmtAST>(context, v, j));
+            ast = v;
+            break;
+        }
+        case ASTType::SwitchStmt:
+        {
+            auto expr = BuildAs<ExprAST>(context, nullptr, j);
+            auto v = context.New<SwitchStmtAST>(parent, expr);
+            expr->SetParent(v);
+            for (j = GetNextSibling(j); j < end; j = GetNextSibling(j))
+                v->AddStmt(BuildAs<StmtAST>(context, v, j));
+            ast = v;
+            break;
+        }
+        case ASTType::LabeledStmt:
+        {
+            auto stmt = (j < end ? BuildAs<StmtAST>(context, nullptr, j) : nullptr);
+            auto v = context.New<LabeledStmtAST>(parent, GetInt(i), stmt);
+            if (nullptr != stmt)
+                stmt->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::WhileStmt:
+        {
+            auto cond = BuildAs<BinaryExprAST>(context, nullptr, j);
+            auto stmt = BuildAs<StmtAST>(context, nullptr, GetNextSibling(j));
+            auto v = context.New<WhileStmtAST>(parent, cond, stmt);
+            cond->SetParent(v);
+            stmt->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::DoStmt:
+        {
+            auto stmt = BuildAs<StmtAST>(context, nullptr, j);
+            auto cond = BuildAs<BinaryExprAST>(context, nullptr, GetNextSibling(j));
+            auto v = context.New<DoStmtAST>(parent, stmt, cond);
+            stmt->SetParent(v);
+            cond->SetParent(v);
+            ast = v;
+            break;
+        }
+        case ASTType::ForStmt:
+        {
+            auto v = context.New<ForStmtAST>(parent);
+            for (std::uint32_t k = 0; k < node.payload; ++k, j = GetNextSibling(j))
+                v->AddInitExpr(BuildAs<AssignExprAST>(context, v, j));
+            v->SetCond(BuildAs<BinaryExprAST>(context, v, j));
+            for (j = GetNextSibling(j); GetNextSibling(j) < end; j = GetNextSibling(j))
+                v->AddUpdateExpr(BuildAs<ExprAST>(context, v, j));
+            v->SetBody(BuildAs<StmtAST>(context, v, j));
+            ast = v;
+            break;
+        }
+        case ASTType::BreakStmt:
+            ast = context.New<BreakStmtAST>(parent);
+            break;
+        case ASTType::ContinueStmt:
+            ast = context.New<ContinueStmtAST>(parent);
+            break;
+        case ASTType::ReturnStmt:
+        {
+            auto v = context.New<ReturnStmtAST>(parent);
+            if (j < end)
+                v->SetExpr(BuildAs<ExprAST>(context, v, j));
+            ast = v;
+            break;
+        }
+
+        case ASTType::VarDecl:
+        {
+            auto v = context.New<VarDeclAST>(parent, 0 != (node.flags & FF_PARAM),
+                0 != (node.flags & FF_CONST), VarType(node.op), GetString(i));
+            // initializer shares the parent of the declaration
+            if (j < end)
+                v->SetExpr(BuildAs<ExprAST>(context, parent, j));
+            ast = v;
+            break;
+        }
+        case ASTType::FuncDecl:
+        {
+            auto v = context.New<FuncDeclAST>(parent, VarType(node.op), GetString(i));
+            for (; j < end; j = GetNextSibling(j))
+            {
+                if (_nodes[j].GetASTType() == ASTType::VarDecl)
+                    v->AddParam(BuildAs<VarDeclAST>(context, v, j));
+                else
+                    v->SetBlockStmt(BuildAs<BlockStmtAST>(context, v, j));
+            }
+            ast = v;
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        if (nullptr != ast)
+            ast->SetTokenIndex(node.token);
+        return ast;
+    }
+}
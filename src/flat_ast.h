@@ -0,0 +1,76 @@
+#pragma once
+#include "all_ast.h"
+#include <unordered_map>
+
+namespace c0
+{
+    enum FlatFlag : std::uint16_t
+    {
+        FF_EXPLICIT = 1 << 0,   // explicit cast or condition with relational operator
+        FF_PARAM    = 1 << 1,   // variable is function parameter
+        FF_CONST    = 1 << 2,   // variable is const
+    };
+
+    /*
+    node of FlatAST, children of a node follow it in pre-order, in the same
+    order as the members of the tree node, so the subtree of node i is
+    [i, i + size).
+    */
+    struct FlatNode
+    {
+        std::uint8_t type;      // ASTType
+        std::uint8_t op;        // BinaryType, UnaryType or VarType
+        std::uint16_t flags;    // FlatFlag
+        std::uint32_t size;     // number of nodes in subtree, itself included
+        std::uint32_t token;    // index of anchor token
+        std::uint32_t payload;  // literal value, index of name/string/float, or number of for init expressions
+
+        ASTType GetASTType() const { return ASTType(type); }
+    };
+
+    /*
+    whole file encoded in one contiguous array of nodes in pre-order, a pass
+    over the whole program is a linear scan, e.g.
+
+        for (std::size_t i = 0, N = flat.GetNodes().size(); i < N; ++i)
+            if (flat.GetNodes()[i].GetASTType() == ASTType::IntExpr) ...
+
+    and a subtree is skipped with GetNextSibling.
+    */
+    class FlatAST
+    {
+    public:
+        FlatAST() = default;
+        explicit FlatAST(const FileAST& file);
+
+        FileASTPtr ToTree() const;
+
+        const std::vector<FlatNode>& GetNodes() const { return _nodes; }
+        const FlatNode& GetNode(std::size_t i) const { return _nodes[i]; }
+        std::size_t GetFirstChild(std::size_t i) const { return i + 1; }
+        std::size_t GetNextSibling(std::size_t i) const { return i + _nodes[i].size; }
+        std::size_t GetChildCount(std::size_t i) const;
+
+        const str_t& GetString(std::size_t i) const { return _strings[_nodes[i].payload]; }
+        int_t GetInt(std::size_t i) const { return int_t(_nodes[i].payload); }
+        char_t GetChar(std::size_t i) const { return char_t(_nodes[i].payload); }
+        float_t GetFloat(std::size_t i) const { return _floats[_nodes[i].payload]; }
+
+    private:
+        void Flatten(const AST& ast);
+        std::uint32_t AddString(const str_t& s);
+
+        ASTPtr Build(ASTContext& context, ASTPtr parent, std::size_t i) const;
+        template<typename T>
+        T* BuildAs(ASTContext& context, ASTPtr parent, std::size_t i) const
+        {
+            return static_cast<T*>(Build(context, parent, i));
+        }
+
+    private:
+        std::vector<FlatNode> _nodes;
+        std::vector<str_t> _strings;    // names and string literals, without duplicates
+        std::unordered_map<str_t, std::uint32_t> _stringIndex;
+        std::vector<float_t> _floats;
+    };
+}
@@ -0,0 +1,589 @@
+#include "sema_analyser.h"
+#include "definite_assignment.h"
+#include <algorithm>
+
+namespace c0
+{
+    namespace
+    {
+        const str_t& GetDeclName(const DeclAST& decl)
+        {
+            if (decl.GetASTType() == ASTType::FuncDecl)
+                return static_cast<const FuncDeclAST&>(decl).GetName();
+            return static_cast<const VarDeclAST&>(decl).GetName();
+        }
+
+        // condition of a loop or update of a for, run after the loop body
+        bool IsLoopExpr(const AST& element)
+        {
+            const auto parent = element.GetParent();
+            if (nullptr == parent)
+                return false;
+            switch (parent->GetASTType())
+            {
+            case ASTType::WhileStmt:
+                return &element == static_cast<const WhileStmtAST*>(parent)->GetCond();
+            case ASTType::DoStmt:
+                return &element == static_cast<const DoStmtAST*>(parent)->GetCond();
+            case ASTType::ForStmt:
+            {
+                const auto forptr = static_cast<const ForStmtAST*>(parent);
+                const auto& updates = forptr->GetUpdateExprs();
+                return &element == forptr->GetCond()
+                    || std::find(updates.begin(), updates.end(), &element) != updates.end();
+            }
+            default:
+                return false;
+            }
+        }
+    }
+
+    bool SemaAnalyser::Analyse(FileASTPtr file, AnalyseError& err)
+    {
+        file->GetSymbolTable().Clear();
+        _warnings.clear();
+
+        for (const auto& var : file->GetVars())
+        {
+            if (!AnalyseTopDecl(file, var, err))
+                return false;
+        }
+
+        for (const auto& func : file->GetFuncs())
+        {
+            if (!AnalyseTopDecl(file, func, err))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool SemaAnalyser::AnalyseTopDecl(FileASTPtr file, DeclASTPtr decl, AnalyseError& err)
+    {
+        _symbols = &file->GetSymbolTable();
+        const auto scope = _symbols->GetScope(*file);
+        if (SymbolTable::NoScope == scope)
+            AnalyseFuncSigns(file, err);
+        else
+            _symbols->SetCurrentScope(scope);
+
+        if (!err)
+        {
+            if (decl->GetASTType() == ASTType::FuncDecl)
+                AnalyseFuncDecl(static_cast<FuncDeclASTPtr>(decl), err);
+            else
+                AnalyseVarDecl(static_cast<VarDeclASTPtr>(decl), err);
+        }
+        if (!err)
+            CheckTopDecl(file, decl, err);
+
+        // a table left half built would hide the symbols not declared yet
+        if (err)
+            _symbols->Clear();
+        return !err;
+    }
+
+    bool SemaAnalyser::AnalyseDecl(FileASTPtr file, DeclASTPtr decl, AnalyseError& err)
+    {
+        if (decl->GetASTType() != ASTType::FuncDecl)
+        {
+            // only the global variables before decl are visible, the file scope cannot be used
+            SymbolTable symbols;
+            symbols.EnterScope(*file);
+            for (const auto& func : file->GetFuncs())
+                symbols.Declare(func->GetName(), func);
+            for (const auto& var : file->GetVars())
+            {
+                if (var == decl)
+                    break;
+                symbols.Declare(var->GetName(), var);
+            }
+
+            _symbols = &symbols;
+            AnalyseVarDecl(static_cast<VarDeclASTPtr>(decl), err);
+            _symbols = nullptr;
+            if (!err)
+                CheckTopDecl(file, decl, err);
+            return !err;
+        }
+
+        // scopes of the old function body are left unreachable, a failed analyse drops the new ones
+        _symbols = &file->GetSymbolTable();
+        const auto mark = _symbols->GetMark();
+        const auto scope = _symbols->GetScope(*file);
+        if (SymbolTable::NoScope == scope)
+        {
+            _symbols->EnterScope(*file);
+            for (const auto& func : file->GetFuncs())
+                _symbols->Declare(func->GetName(), func);
+            for (const auto& var : file->GetVars())
+                _symbols->Declare(var->GetName(), var);
+        }
+        else
+            _symbols->SetCurrentScope(scope);
+
+        AnalyseFuncDecl(static_cast<FuncDeclASTPtr>(decl), err);
+        if (!err)
+            CheckTopDecl(file, decl, err);
+        if (err)
+            _symbols->Rewind(mark);
+        return !err;
+    }
+
+    void SemaAnalyser::AnalyseFuncSigns(FileASTPtr file, AnalyseError& err)
+    {
+        _symbols->EnterScope(*file);
+
+        for (const auto& func : file->GetFuncs())
+        {
+            Declare(func, err);
+            if (err)
+            {
+                err = AnalyseError("function name repeated", GetToken(*func));
+                return;
+            }
+        }
+    }
+
+    void SemaAnalyser::AnalyseVarDecl(VarDeclASTPtr var, AnalyseError& err)
+    {
+        if (var->HasExpr())
+        {
+            // functions are declared before the globals only for the calls of bodies
+            _isGlobalInit = (var->GetParent()->GetASTType() == ASTType::File);
+            AnalyseExpr(var->GetExpr(), err, var->IsConst());
+            _isGlobalInit = false;
+            if (err)
+                return;
+        }
+
+        Declare(var, err);
+    }
+
+    void SemaAnalyser::AnalyseFuncDecl(FuncDeclASTPtr func, AnalyseError& err)
+    {
+        _symbols->EnterScope(*func);
+        func->SetSymbolTable(_symbols);
+        _symbols->Declare(func->GetName(), func);
+
+        for (const auto& param : func->GetParams())
+        {
+            Declare(param, err);
+            if (err)
+                return;
+        }
+
+        if (nullptr != func->GetBlockStmt())
+        {
+            AnalyseBlockStmt(func->GetBlockStmt(), err);
+            if (err)
+                return;
+        }
+
+        _symbols->LeaveScope();
+    }
+
+    void SemaAnalyser::CheckTopDecl(FileASTPtr file, DeclASTPtr decl, AnalyseError& err)
+    {
+        AnalyseErrorList errs;
+        if (!_checker.CheckDecl(file, decl, errs))
+        {
+            err = errs.front();
+            return;
+        }
+
+        if (decl->GetASTType() == ASTType::FuncDecl && nullptr != static_cast<FuncDeclASTPtr>(decl)->GetBlockStmt())
+            CheckFuncFlow(static_cast<FuncDeclASTPtr>(decl));
+    }
+
+    void SemaAnalyser::CheckFuncFlow(FuncDeclASTPtr func)
+    {
+        const CFG cfg(*func);
+
+        // a block into Exit not ending with return is the end of the body
+        if (VarType::Void != func->GetVarType())
+        {
+            for (std::size_t i = 0, N = cfg.GetPredCount(CFG::Exit); i < N; ++i)
+            {
+                const auto pred = cfg.GetPred(CFG::Exit, i);
+                const auto count = cfg.GetElementCount(pred);
+                if (cfg.IsReachable(pred)
+                    && (0 == count || cfg.GetElement(pred, count - 1).GetASTType() != ASTType::ReturnStmt))
+                {
+                    _warnings.emplace_back("missing return at the end of non-void function", GetToken(*func), true);
+                    break;
+                }
+            }
+        }
+
+        // blocks are about in source order, the dead code following the first one found is not warned again.
+        // a loop condition or for update left dead by a body always returning is not code written dead
+        std::vector<char> isWarned(cfg.GetBlockCount(), 0);
+        std::vector<std::size_t> work;
+        for (std::size_t block = 0, N = cfg.GetBlockCount(); block < N; ++block)
+        {
+            if (cfg.IsReachable(block) || isWarned[block] || 0 == cfg.GetElementCount(block)
+                || IsLoopExpr(cfg.GetElement(block, 0)))
+                continue;
+
+            _warnings.emplace_back("unreachable code", GetToken(cfg.GetElement(block, 0)), true);
+            isWarned[block] = 1;
+            work.push_back(block);
+            while (!work.empty())
+            {
+                const auto dead = work.back();
+                work.pop_back();
+                for (std::size_t i = 0, M = cfg.GetSuccCount(dead); i < M; ++i)
+                {
+                    const auto succ = cfg.GetSucc(dead, i);
+                    if (!cfg.IsReachable(succ) && !isWarned[succ])
+                    {
+                        isWarned[succ] = 1;
+                        work.push_back(succ);
+                    }
+                }
+            }
+        }
+
+        const DefiniteAssignment assignment(*func, cfg);
+        for (const auto read : assignment.GetUninitReads())
+            _warnings.emplace_back("variable '" + read->GetName() + "' may be used before assigned", GetToken(*read), true);
+    }
+
+    //-------------------------------------------------------------------------
+
+    void SemaAnalyser::AnalyseStmt(StmtASTPtr stmt, AnalyseError& err)
+    {
+        if (nullptr == stmt)
+            return;
+
+        switch (stmt->GetASTType())
+        {
+        case ASTType::BlockStmt:
+            AnalyseBlockStmt(static_cast<BlockStmtASTPtr>(stmt), err);
+            break;
+
+        case ASTType::PrintStmt:
+            for (const auto& param : static_cast<PrintStmtASTPtr>(stmt)->GetParams())
+            {
+                AnalyseExpr(param, err, false);
+                if (err)
+                    return;
+            }
+            break;
+
+        case ASTType::ScanStmt:
+            AnalyseScanStmt(static_cast<ScanStmtASTPtr>(stmt), err);
+            break;
+
+        case ASTType::AssignStmt:
+            AnalyseAssignStmt(static_cast<AssignStmtASTPtr>(stmt), err);
+            break;
+
+        case ASTType::FuncCallStmt:
+            AnalyseFuncCallStmt(static_cast<FuncCallStmtASTPtr>(stmt), err);
+            break;
+
+        case ASTType::IfStmt:
+        {
+            auto ifptr = static_cast<IfStmtASTPtr>(stmt);
+            AnalyseExpr(ifptr->GetIfCond(), err, false);
+            if (err)
+                return;
+            AnalyseStmt(ifptr->GetIFStmt(), err);
+            if (err)
+                return;
+            AnalyseStmt(ifptr->GetElseStmt(), err);
+            break;
+        }
+
+        case ASTType::SwitchStmt:
+            AnalyseSwitchStmt(static_cast<SwitchStmtASTPtr>(stmt), err);
+            break;
+
+        case ASTType::LabeledStmt:
+            AnalyseStmt(static_cast<LabeledStmtASTPtr>(stmt)->GetStmt(), err);
+            break;
+
+        case ASTType::WhileStmt:
+        {
+            auto whileptr = static_cast<WhileStmtASTPtr>(stmt);
+            AnalyseExpr(whileptr->GetCond(), err, false);
+            if (err)
+                return;
+            AnalyseStmt(whileptr->GetStmt(), err);
+            break;
+        }
+
+        case ASTType::DoStmt:
+        {
+            auto doptr = static_cast<DoStmtASTPtr>(stmt);
+            AnalyseStmt(doptr->GetStmt(), err);
+            if (err)
+                return;
+            AnalyseExpr(doptr->GetCond(), err, false);
+            break;
+        }
+
+        case ASTType::ForStmt:
+            AnalyseForStmt(static_cast<ForStmtASTPtr>(stmt), err);
+            break;
+
+        case ASTType::ReturnStmt:
+            AnalyseReturnStmt(static_cast<ReturnStmtASTPtr>(stmt), err);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void SemaAnalyser::AnalyseBlockStmt(BlockStmtASTPtr block, AnalyseError& err)
+    {
+        _symbols->EnterScope(*block);
+        block->SetSymbolTable(_symbols);
+
+        for (const auto& var : block->GetVars())
+        {
+            AnalyseVarDecl(var, err);
+            if (err)
+                return;
+        }
+
+        for (const auto& stmt : block->GetStmts())
+        {
+            AnalyseStmt(stmt, err);
+            if (err)
+                return;
+        }
+
+        _symbols->LeaveScope();
+    }
+
+    void SemaAnalyser::AnalyseScanStmt(ScanStmtASTPtr scan, AnalyseError& err)
+    {
+        const auto symbol = FindSymbol(scan->GetName());
+        if (nullptr == symbol || symbol->GetASTType() != ASTType::VarDecl)
+        {
+            err = AnalyseError("cannot find variable in scan statement", GetToken(*scan));
+            return;
+        }
+        if (static_cast<VarDeclASTPtr>(symbol)->IsConst())
+        {
+            err = AnalyseError("cannot scan into const variable", GetToken(*scan));
+            return;
+        }
+        scan->SetDecl(symbol);
+    }
+
+    void SemaAnalyser::AnalyseAssignStmt(AssignStmtASTPtr assign, AnalyseError& err)
+    {
+        const auto symbol = FindSymbol(assign->GetName());
+        if (nullptr == symbol || symbol->GetASTType() != ASTType::VarDecl)
+        {
+            err = AnalyseError("cannot find variable in assignment statement", GetToken(*assign));
+            return;
+        }
+        const auto vardecl = static_cast<VarDeclASTPtr>(symbol);
+        if (vardecl->IsConst())
+        {
+            err = AnalyseError("cannot assign on const variable in assignment statement", GetToken(*assign));
+            return;
+        }
+        assign->SetDecl(vardecl);
+
+        AnalyseExpr(assign->GetExpr(), err, false);
+    }
+
+    void SemaAnalyser::AnalyseFuncCallStmt(FuncCallStmtASTPtr funccall, AnalyseError& err)
+    {
+        const auto symbol = FindSymbol(funccall->GetName());
+        if (nullptr == symbol || symbol->GetASTType() != ASTType::FuncDecl)
+        {
+            err = AnalyseError("identifier is not a function name in function call statement", GetToken(*funccall));
+            return;
+        }
+        funccall->SetDecl(symbol);
+
+        for (const auto& param : funccall->GetParams())
+        {
+            AnalyseExpr(param, err, false);
+            if (err)
+                return;
+        }
+    }
+
+    void SemaAnalyser::AnalyseSwitchStmt(SwitchStmtASTPtr switchptr, AnalyseError& err)
+    {
+        AnalyseExpr(switchptr->GetExpr(), err, false);
+        if (err)
+            return;
+
+        for (const auto& stmt : switchptr->GetStmts())
+        {
+            AnalyseStmt(stmt, err);
+            if (err)
+                return;
+        }
+    }
+
+    void SemaAnalyser::AnalyseForStmt(ForStmtASTPtr forptr, AnalyseError& err)
+    {
+        for (const auto& expr : forptr->GetInitExprs())
+        {
+            AnalyseAssignExpr(expr, err);
+            if (err)
+                return;
+        }
+
+        AnalyseExpr(forptr->GetCond(), err, false);
+        if (err)
+            return;
+
+        for (const auto& expr : forptr->GetUpdateExprs())
+        {
+            AnalyseExpr(expr, err, false);
+            if (err)
+                return;
+        }
+
+        AnalyseStmt(forptr->GetBody(), err);
+    }
+
+    void SemaAnalyser::AnalyseReturnStmt(ReturnStmtASTPtr ret, AnalyseError& err)
+    {
+        if (nullptr != ret->GetExpr())
+            AnalyseExpr(ret->GetExpr(), err, false);
+    }
+
+    //-------------------------------------------------------------------------
+
+    void SemaAnalyser::AnalyseExpr(ExprASTPtr expr, AnalyseError& err, bool isNeedConst)
+    {
+        switch (expr->GetASTType())
+        {
+        case ASTType::BinaryExpr:
+        {
+            auto binary = static_cast<BinaryExprASTPtr>(expr);
+            AnalyseExpr(binary->GetLeftExpr(), err, isNeedConst);
+            if (err)
+                return;
+            AnalyseExpr(binary->GetRightExpr(), err, isNeedConst);
+            break;
+        }
+
+        case ASTType::CastExpr:
+            AnalyseExpr(static_cast<CastExprASTPtr>(expr)->GetExpr(), err, isNeedConst);
+            break;
+
+        case ASTType::UnaryExpr:
+            AnalyseExpr(static_cast<UnaryExprASTPtr>(expr)->GetExpr(), err, isNeedConst);
+            break;
+
+        case ASTType::BraceExpr:
+            AnalyseExpr(static_cast<BraceExprASTPtr>(expr)->GetExpr(), err, isNeedConst);
+            break;
+
+        case ASTType::IdentExpr:
+            AnalyseIdentExpr(static_cast<IdentExprASTPtr>(expr), err, isNeedConst);
+            break;
+
+        case ASTType::AssignExpr:
+            AnalyseAssignExpr(static_cast<AssignExprASTPtr>(expr), err);
+            break;
+
+        case ASTType::FuncCallExpr:
+            if (isNeedConst)
+            {
+                err = AnalyseError("expect const express but got function call", GetToken(*expr));
+                return;
+            }
+            AnalyseFuncCallExpr(static_cast<FuncCallExprASTPtr>(expr), err);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void SemaAnalyser::AnalyseIdentExpr(IdentExprASTPtr expr, AnalyseError& err, bool isNeedConst)
+    {
+        const auto symbol = FindSymbol(expr->GetName());
+        if (nullptr == symbol || symbol->GetASTType() != ASTType::VarDecl)
+        {
+            err = AnalyseError("unknown identifier in primary expression", GetToken(*expr));
+            return;
+        }
+        if (isNeedConst && symbol->GetDeclType() != DeclType::ConstVar)
+        {
+            err = AnalyseError("expect const variable", GetToken(*expr));
+            return;
+        }
+        expr->SetDecl(symbol);
+    }
+
+    void SemaAnalyser::AnalyseAssignExpr(AssignExprASTPtr expr, AnalyseError& err)
+    {
+        const auto symbol = FindSymbol(expr->GetName());
+        if (nullptr == symbol || symbol->GetASTType() != ASTType::VarDecl)
+        {
+            err = AnalyseError("cannot find variable in assignment expression", GetToken(*expr));
+            return;
+        }
+        const auto vardecl = static_cast<VarDeclASTPtr>(symbol);
+        if (vardecl->IsConst())
+        {
+            err = AnalyseError("cannot assign on const variable in assignment expression", GetToken(*expr));
+            return;
+        }
+        expr->SetDecl(vardecl);
+
+        AnalyseExpr(expr->GetExpr(), err, false);
+    }
+
+    void SemaAnalyser::AnalyseFuncCallExpr(FuncCallExprASTPtr expr, AnalyseError& err)
+    {
+        // a function called before all the globals are initialized could read one that is not
+        if (_isGlobalInit)
+        {
+            err = AnalyseError("function call in global variable initializer", GetToken(*expr));
+            return;
+        }
+
+        const auto symbol = FindSymbol(expr->GetName());
+        if (nullptr == symbol || symbol->GetASTType() != ASTType::FuncDecl)
+        {
+            err = AnalyseError("identifier is not a function name in function call expression", GetToken(*expr));
+            return;
+        }
+        expr->SetDecl(symbol);
+
+        for (const auto& param : expr->GetParams())
+        {
+            AnalyseExpr(param, err, false);
+            if (err)
+                return;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    void SemaAnalyser::Declare(DeclASTPtr decl, AnalyseError& err)
+    {
+        if (!_symbols->Declare(GetDeclName(*decl), decl))
+            err = AnalyseError("variable name repeated", GetToken(*decl));
+    }
+
+    DeclASTPtr SemaAnalyser::FindSymbol(const str_t& name) const
+    {
+        return _symbols->Find(name);
+    }
+
+    Token SemaAnalyser::GetToken(const AST& ast, std::size_t offset) const
+    {
+        const auto pos = ast.GetTokenIndex() + offset;
+        if (pos >= _tokens.size())
+            return Token();
+        return _tokens[pos];
+    }
+}
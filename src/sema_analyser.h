@@ -0,0 +1,79 @@
+#pragma once
+#include "type_checker.h"
+
+namespace c0
+{
+    /*
+    semantic analyse on the ast built by Analyser::Parse: symbols are resolved,
+    duplicated names are rejected and const variables are kept read-only. the
+    scopes are built into the symbol table of the file, left there for
+    GetSymbol of later passes.
+
+    once the names of a top-level declaration are bound, TypeChecker checks
+    its types and inserts the implicit casts. the first error of the checker
+    is reported, so a declaration stops at its first binding error or else at
+    its first type error.
+
+    the control flow of each function body is checked once it is analysed,
+    all as warnings: a non-void function that can reach its end without
+    return, the first statement of each piece of unreachable code and a read
+    of a local variable that may not be assigned yet.
+    */
+    class SemaAnalyser
+    {
+    public:
+        SemaAnalyser(const TokenList& tokens) : _tokens(tokens), _checker(tokens) {}
+
+        bool Analyse(FileASTPtr file, AnalyseError& err);
+
+        /*
+        analyse the top-level declarations of file one by one in source order,
+        functions of file are declared at the first call, a global variable is
+        declared after it is analysed.
+        */
+        bool AnalyseTopDecl(FileASTPtr file, DeclASTPtr decl, AnalyseError& err);
+
+        /*
+        analyse one top-level declaration of file again, functions and the
+        global variables declared before decl are visible.
+        */
+        bool AnalyseDecl(FileASTPtr file, DeclASTPtr decl, AnalyseError& err);
+
+        // warnings of all the declarations analysed
+        const AnalyseWarningList& GetWarnings() const { return _warnings; }
+
+    private:
+        void AnalyseFuncSigns(FileASTPtr file, AnalyseError& err);
+        void AnalyseVarDecl(VarDeclASTPtr var, AnalyseError& err);
+        void AnalyseFuncDecl(FuncDeclASTPtr func, AnalyseError& err);
+        void CheckFuncFlow(FuncDeclASTPtr func);
+
+        void AnalyseStmt(StmtASTPtr stmt, AnalyseError& err);
+        void AnalyseBlockStmt(BlockStmtASTPtr block, AnalyseError& err);
+        void AnalyseScanStmt(ScanStmtASTPtr scan, AnalyseError& err);
+        void AnalyseAssignStmt(AssignStmtASTPtr assign, AnalyseError& err);
+        void AnalyseFuncCallStmt(FuncCallStmtASTPtr funccall, AnalyseError& err);
+        void AnalyseSwitchStmt(SwitchStmtASTPtr switchptr, AnalyseError& err);
+        void AnalyseForStmt(ForStmtASTPtr forptr, AnalyseError& err);
+        void AnalyseReturnStmt(ReturnStmtASTPtr ret, AnalyseError& err);
+
+        void AnalyseExpr(ExprASTPtr expr, AnalyseError& err, bool isNeedConst);
+        void AnalyseIdentExpr(IdentExprASTPtr expr, AnalyseError& err, bool isNeedConst);
+        void AnalyseAssignExpr(AssignExprASTPtr expr, AnalyseError& err);
+        void AnalyseFuncCallExpr(FuncCallExprASTPtr expr, AnalyseError& err);
+
+        // types of a top-level declaration bound already, then the flow of a function
+        void CheckTopDecl(FileASTPtr file, DeclASTPtr decl, AnalyseError& err);
+
+        void Declare(DeclASTPtr decl, AnalyseError& err);
+        DeclASTPtr FindSymbol(const str_t& name) const;
+        Token GetToken(const AST& ast, std::size_t offset = 0) const;
+
+    private:
+        const TokenList& _tokens;
+        TypeChecker _checker;
+        SymbolTable* _symbols = nullptr;    // current scope is the innermost one
+        bool _isGlobalInit = false;         // analysing the initializer of a global variable
+        AnalyseWarningList _warnings;
+    };
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+
+namespace c0
+{
+    /*
+    vector of trivially copyable elements, the first N elements are stored in
+    the object itself and the heap is only used once it grows over N, so a
+    child list of one or two nodes costs no allocation. the interface is the
+    subset of std::vector used on ast child lists.
+    */
+    template<typename T, std::size_t N>
+    class SmallVector
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable elements");
+        static_assert(N > 0, "SmallVector needs inline capacity");
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        SmallVector() = default;
+        SmallVector(size_type count, const T& value) { assign(count, value); }
+        SmallVector(std::initializer_list<T> list) { Append(list.begin(), list.size()); }
+        SmallVector(const SmallVector& other) { Append(other.begin(), other.size()); }
+        SmallVector(SmallVector&& other) { Steal(other); }
+        ~SmallVector() { Release(); }
+
+        SmallVector& operator=(const SmallVector& other)
+        {
+            if (this != &other)
+            {
+                _size = 0;
+                Append(other.begin(), other.size());
+            }
+            return *this;
+        }
+        SmallVector& operator=(SmallVector&& other)
+        {
+            if (this != &other)
+            {
+                Release();
+                Steal(other);
+            }
+            return *this;
+        }
+
+        iterator begin() { return _data; }
+        iterator end() { return _data + _size; }
+        const_iterator begin() const { return _data; }
+        const_iterator end() const { return _data + _size; }
+
+        size_type size() const { return _size; }
+        size_type capacity() const { return _capacity; }
+        bool empty() const { return 0 == _size; }
+        bool IsInline() const { return _data == Inline(); }
+
+        T* data() { return _data; }
+        const T* data() const { return _data; }
+        reference operator[](size_type i) { return _data[i]; }
+        const_reference operator[](size_type i) const { return _data[i]; }
+        reference front() { return _data[0]; }
+        const_reference front() const { return _data[0]; }
+        reference back() { return _data[_size - 1]; }
+        const_reference back() const { return _data[_size - 1]; }
+
+        void push_back(const T& value)
+        {
+            if (_size == _capacity)
+            {
+                // value may live in this vector
+                const T copy = value;
+                Grow(_size + 1);
+                _data[_size++] = copy;
+                return;
+            }
+            _data[_size++] = value;
+        }
+        void pop_back() { --_size; }
+        void clear() { _size = 0; }
+
+        void reserve(size_type n)
+        {
+            if (n > _capacity)
+                Grow(n);
+        }
+        void resize(size_type n, const T& value = T())
+        {
+            reserve(n);
+            for (auto i = _size; i < n; ++i)
+                _data[i] = value;
+            _size = static_cast<std::uint32_t>(n);
+        }
+        void assign(size_type count, const T& value)
+        {
+            _size = 0;
+            resize(count, value);
+        }
+
+        iterator insert(const_iterator pos, const T& value)
+        {
+            const auto i = static_cast<size_type>(pos - _data);
+            const T copy = value;
+            reserve(_size + 1);
+            std::memmove(_data + i + 1, _data + i, (_size - i) * sizeof(T));
+            _data[i] = copy;
+            ++_size;
+            return _data + i;
+        }
+        iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            const auto i = static_cast<size_type>(first - _data);
+            const auto n = static_cast<size_type>(last - first);
+            std::memmove(_data + i, _data + i + n, (_size - i - n) * sizeof(T));
+            _size -= static_cast<std::uint32_t>(n);
+            return _data + i;
+        }
+
+        bool operator==(const SmallVector& other) const
+        {
+            if (_size != other._size)
+                return false;
+            for (size_type i = 0; i < _size; ++i)
+            {
+                if (!(_data[i] == other._data[i]))
+                    return false;
+            }
+            return true;
+        }
+        bool operator!=(const SmallVector& other) const { return !(*this == other); }
+
+    private:
+        T* Inline() { return reinterpret_cast<T*>(&_inline); }
+        const T* Inline() const { return reinterpret_cast<const T*>(&_inline); }
+
+        void Append(const T* values, size_type n)
+        {
+            reserve(_size + n);
+            if (0 != n)
+                std::memcpy(_data + _size, values, n * sizeof(T));
+            _size += static_cast<std::uint32_t>(n);
+        }
+
+        void Grow(size_type n)
+        {
+            auto capacity = size_type(_capacity) * 2;
+            if (capacity < n)
+                capacity = n;
+
+            auto data = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+            if (nullptr == data)
+                throw std::bad_alloc();
+            if (0 != _size)
+                std::memcpy(data, _data, _size * sizeof(T));
+            Release();
+            _data = data;
+            _capacity = static_cast<std::uint32_t>(capacity);
+        }
+
+        void Release()
+        {
+            if (!IsInline())
+                std::free(_data);
+            _data = Inline();
+            _capacity = N;
+        }
+
+        // other is left empty
+        void Steal(SmallVector& other)
+        {
+            if (other.IsInline())
+            {
+                _size = 0;
+                Append(other.begin(), other.size());
+            }
+            else
+            {
+                _data = other._data;
+                _size = other._size;
+                _capacity = other._capacity;
+                other._data = other.Inline();
+                other._capacity = N;
+            }
+            other._size = 0;
+        }
+
+    private:
+        typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type _inline;
+        T* _data = Inline();
+        std::uint32_t _size = 0;
+        std::uint32_t _capacity = N;
+    };
+}
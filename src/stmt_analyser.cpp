@@ -8,7 +8,7 @@ namespace c0
     <statement-seq> ::=
         {<statement>}
     */
-    BlockStmtASTPtr Analyser::AnalyseBlockStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue)
+    BlockStmtASTPtr Analyser::AnalyseBlockStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue)
     {
         auto token = ReadToken();
         if (token.GetType() != TokenType::S_LPARENTHESES)
@@ -17,7 +17,7 @@ namespace c0
             return nullptr;
         }
 
-        auto block = std::make_shared<BlockStmtAST>(parent);
+        auto block = NewAST<BlockStmtAST>(_cur - 1, parent);
 
         for (token = PeekToken();
             token.GetType() == TokenType::R_CONST 
@@ -36,7 +36,7 @@ namespace c0
             token = PeekToken())
         {
             bool isSemicolon = false;
-            auto stmt = AnalyseStmt(block, err, retType, canBreak, canContinue, &isSemicolon);
+            auto stmt = AnalyseStmt(block, err, canBreak, canContinue, &isSemicolon);
             if (err)
                 return nullptr;
 
@@ -68,7 +68,7 @@ namespace c0
         |<function-call>';'
         |';'
     */
-    StmtASTPtr Analyser::AnalyseStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue, bool* isSemicolon /*= nullptr*/)
+    StmtASTPtr Analyser::AnalyseStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue, bool* isSemicolon /*= nullptr*/)
     {
         if (nullptr != isSemicolon)
             *isSemicolon = false;
@@ -82,21 +82,21 @@ namespace c0
             return nullptr;
 
         case TokenType::S_LPARENTHESES:
-            return AnalyseBlockStmt(parent, err, retType, canBreak, canContinue);
+            return AnalyseBlockStmt(parent, err, canBreak, canContinue);
 
         case TokenType::R_IF:
         case TokenType::R_SWITCH:
-            return AnalyseCondStmt(parent, err, retType, canBreak, canContinue);
+            return AnalyseCondStmt(parent, err, canBreak, canContinue);
 
         case TokenType::R_WHILE:
         case TokenType::R_DO:
         case TokenType::R_FOR:
-            return AnalyseLoopStmt(parent, err, retType);
+            return AnalyseLoopStmt(parent, err);
 
         case TokenType::R_BREAK:
         case TokenType::R_CONTINUE:
         case TokenType::R_RETURN:
-            return AnalyseJumpStmt(parent, err, retType, canBreak, canContinue);
+            return AnalyseJumpStmt(parent, err, canBreak, canContinue);
 
         case TokenType::R_PRINT:
             return AnalysePrintStmt(parent, err);
@@ -110,17 +110,15 @@ namespace c0
 
         if (token.GetType() == TokenType::IDENT)
         {
-            const auto t = parent->GetSymbolType(token.GetString(), true);
+            const auto la = GetIdentLookahead(PeekToken(1).GetType());
 
             StmtASTPtr stmt = nullptr;
-            if (t == SymbolType::Var)
+            if (la == Lookahead::Assign)
                 stmt = AnalyseAssignStmt(parent, err);
-            else if (t == SymbolType::Func)
+            else if (la == Lookahead::FuncCall)
                 stmt = AnalyseFuncCallStmt(parent, err);
-            else if (t == SymbolType::ConstVar)
-                err = AnalyseError("cannot change const variable", token);
             else
-                err = AnalyseError("unknown identifier in statement", token);
+                err = AnalyseError("expect '=' or '(' after identifier in statement", PeekToken(1));
 
             if (err)
                 return nullptr;
@@ -128,7 +126,7 @@ namespace c0
             token = ReadToken();
             if (token.GetType() != TokenType::S_SEMICOLON)
             {
-                if (t == SymbolType::Var)
+                if (la == Lookahead::Assign)
                     err = AnalyseError("expect ';' after assignment", token);
                 else
                     err = AnalyseError("expect ';' after function call", token);
@@ -148,13 +146,13 @@ namespace c0
         'if' '(' <condition> ')' <statement> ['else' <statement>]
         |'switch' '(' <expression> ')' '{' {<labeled-statement>} '}'
     */
-    CondStmtASTPtr Analyser::AnalyseCondStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue)
+    CondStmtASTPtr Analyser::AnalyseCondStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue)
     {
         auto token = PeekToken();
         if (token.GetType() == TokenType::R_IF)
-            return AnalyseIfStmt(parent, err, retType, canBreak, canContinue);
+            return AnalyseIfStmt(parent, err, canBreak, canContinue);
         else if (token.GetType() == TokenType::R_SWITCH)
-            return AnalyseSwitchStmt(parent, err, retType, canContinue);
+            return AnalyseSwitchStmt(parent, err, canContinue);
         
         err = AnalyseError("unsupported condition statement", token);
         return nullptr;
@@ -166,15 +164,15 @@ namespace c0
         |'do' <statement> 'while' '(' <condition> ')' ';'
         |'for' '('<for-init-statement> [<condition>]';' [<for-update-expression>]')' <statement>
     */
-    LoopStmtASTPtr Analyser::AnalyseLoopStmt(ASTPtr parent, AnalyseError& err, VarType retType)
+    LoopStmtASTPtr Analyser::AnalyseLoopStmt(ASTPtr parent, AnalyseError& err)
     {
         auto token = PeekToken();
         if (token.GetType() == TokenType::R_WHILE)
-            return AnalyseWhileStmt(parent, err, retType);
+            return AnalyseWhileStmt(parent, err);
         else if (token.GetType() == TokenType::R_DO)
-            return AnalyseDoStmt(parent, err, retType);
+            return AnalyseDoStmt(parent, err);
         else if (token.GetType() == TokenType::R_FOR)
-            return AnalyseForStmt(parent, err, retType);
+            return AnalyseForStmt(parent, err);
 
         err = AnalyseError("unsupported loop statement", token);
         return nullptr;
@@ -186,7 +184,7 @@ namespace c0
         |'continue' ';'
         |<return-statement>
     */
-    JumpStmtASTPtr Analyser::AnalyseJumpStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue)
+    JumpStmtASTPtr Analyser::AnalyseJumpStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue)
     {
         auto token = PeekToken();
         if (token.GetType() == TokenType::R_BREAK)
@@ -194,7 +192,7 @@ namespace c0
         else if (token.GetType() == TokenType::R_CONTINUE)
             return AnalyseContinueStmt(parent, err, canContinue);
         else if (token.GetType() == TokenType::R_RETURN)
-            return AnalyseReturnStmt(parent, err, retType);
+            return AnalyseReturnStmt(parent, err);
 
         err = AnalyseError("unsupported jump statement", token);
         return nullptr;
@@ -222,13 +220,13 @@ namespace c0
             return nullptr;
         }
 
-        auto print = std::make_shared<PrintStmtAST>(parent);
+        auto print = NewAST<PrintStmtAST>(_cur - 2, parent);
 
         for (token = PeekToken();
             token.GetType() != TokenType::S_RBRACES;
             token = PeekToken())
         {
-            auto param = AnalyseExpr(parent, err, false);
+            auto param = AnalyseExpr(print, err);
             if (err)
                 return nullptr;
             print->AddParam(param);
@@ -274,6 +272,7 @@ namespace c0
             return nullptr;
         }
 
+        const auto namePos = _cur;
         token = ReadToken();
         if (token.GetType() != TokenType::IDENT)
         {
@@ -296,7 +295,7 @@ namespace c0
             return nullptr;
         }
 
-        return std::make_shared<ScanStmtAST>(parent, varName);
+        return NewAST<ScanStmtAST>(namePos, parent, varName);
     }
 
     /*
@@ -306,6 +305,7 @@ namespace c0
     */
     AssignStmtASTPtr Analyser::AnalyseAssignStmt(ASTPtr parent, AnalyseError& err)
     {
+        const auto namePos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::IDENT)
         {
@@ -313,17 +313,6 @@ namespace c0
             return nullptr;
         }
         const auto varName = token.GetString();
-        auto vardecl = std::dynamic_pointer_cast<VarDeclAST>(parent->GetSymbol(varName, true));
-        if (nullptr == vardecl)
-        {
-            err = AnalyseError("cannot find variable in assignment statement", token);
-            return nullptr;
-        }
-        if (vardecl->IsConst())
-        {
-            err = AnalyseError("cannot assign on const variable in assignment statement", token);
-            return nullptr;
-        }
 
         token = ReadToken();
         if (token.GetType() != TokenType::S_ASSIGN)
@@ -332,16 +321,11 @@ namespace c0
             return nullptr;
         }
 
-        auto expr = AnalyseExpr(parent, err, false);
-        if (err)
-            return nullptr;
-
-        expr = CheckInexplicitTypeCast(parent, err, token, expr, vardecl->GetVarType(),
-            "invalid assignment statement, ");
+        auto expr = AnalyseExpr(parent, err);
         if (err)
             return nullptr;
 
-        auto tmp = std::make_shared<AssignStmtAST>(parent, varName, expr);
+        auto tmp = NewAST<AssignStmtAST>(namePos, parent, varName, expr);
         tmp->GetExpr()->SetParent(tmp);
         return tmp;
     }
@@ -354,6 +338,7 @@ namespace c0
     */
     FuncCallStmtASTPtr Analyser::AnalyseFuncCallStmt(ASTPtr parent, AnalyseError& err)
     {
+        const auto namePos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::IDENT)
         {
@@ -361,12 +346,6 @@ namespace c0
             return nullptr;
         }
         const auto funcName = token.GetString();
-        const auto funcimpl = std::dynamic_pointer_cast<FuncDeclAST>(parent->GetSymbol(funcName, true));
-        if (nullptr == funcimpl)
-        {
-            err = AnalyseError("identifier is not a function name in function call statement", token);
-            return nullptr;
-        }
 
         token = ReadToken();
         if (token.GetType() != TokenType::S_LBRACES)
@@ -375,41 +354,22 @@ namespace c0
             return nullptr;
         }
 
-        auto funccall = std::make_shared<FuncCallStmtAST>(parent, funcName);
-        ExprASTPtrList callParams;
+        auto funccall = NewAST<FuncCallStmtAST>(namePos, parent, funcName);
 
         for (token = PeekToken();
             token.GetType() != TokenType::S_RBRACES;
             token = PeekToken())
         {
-            auto param = AnalyseExpr(parent, err, false);
+            auto param = AnalyseExpr(funccall, err);
             if (err)
                 return nullptr;
-            callParams.push_back(param);
+            funccall->AddParam(param);
 
             token = PeekToken();
             if (token.GetType() == TokenType::S_COMMA)
                 ReadToken();
         }
 
-        const auto& declParams = funcimpl->GetParams();
-        if (callParams.size() != declParams.size())
-        {
-            err = AnalyseError("parameter number mismatch in function call statement, need "
-                + std::to_string(declParams.size())
-                + ", have " + std::to_string(callParams.size())
-                , token);
-            return nullptr;
-        }
-        for (size_t i = 0, N = callParams.size(); i < N; ++i)
-        {
-            auto param = CheckInexplicitTypeCast(funccall, err, token, callParams[i], declParams[i]->GetVarType(),
-                "for " + std::to_string(i) + "th function param in function call statement, ");
-            if (err)
-                return nullptr;
-            funccall->AddParam(param);
-        }
-
         token = ReadToken();
         if (token.GetType() != TokenType::S_RBRACES)
         {
@@ -423,8 +383,9 @@ namespace c0
     /*
     'if' '(' <condition> ')' <statement> ['else' <statement>]
     */
-    IfStmtASTPtr Analyser::AnalyseIfStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canBreak, bool canContinue)
+    IfStmtASTPtr Analyser::AnalyseIfStmt(ASTPtr parent, AnalyseError& err, bool canBreak, bool canContinue)
     {
+        const auto ifPos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::R_IF)
         {
@@ -449,12 +410,12 @@ namespace c0
             return nullptr;
         }
 
-        auto ifstmt = AnalyseStmt(parent, err, retType, canBreak, canContinue);
+        auto ifstmt = AnalyseStmt(parent, err, canBreak, canContinue);
         if (err)
             return nullptr;
         if (nullptr == ifstmt)
-            ifstmt = std::make_shared<EmptyStmtAST>(parent);
-        auto ifptr = std::make_shared<IfStmtAST>(parent, ifcond, ifstmt);
+            ifstmt = NewAST<EmptyStmtAST>(_cur - 1, parent);
+        auto ifptr = NewAST<IfStmtAST>(ifPos, parent, ifcond, ifstmt);
         ifcond->SetParent(ifptr);
         ifstmt->SetParent(ifptr);
 
@@ -463,7 +424,7 @@ namespace c0
         {
             ReadToken();
 
-            auto elsestat = AnalyseStmt(ifptr, err, retType, canBreak, canContinue);
+            auto elsestat = AnalyseStmt(ifptr, err, canBreak, canContinue);
             if (err)
                 return nullptr;
 
@@ -476,8 +437,9 @@ namespace c0
     /*
     'switch' '(' <expression> ')' '{' {<labeled-statement>} '}'
     */
-    SwitchStmtASTPtr Analyser::AnalyseSwitchStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canContinue)
+    SwitchStmtASTPtr Analyser::AnalyseSwitchStmt(ASTPtr parent, AnalyseError& err, bool canContinue)
     {
+        const auto switchPos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::R_SWITCH)
         {
@@ -491,15 +453,9 @@ namespace c0
             return nullptr;
         }
 
-        auto cond = AnalyseExpr(parent, err, false);
+        auto cond = AnalyseExpr(parent, err);
         if (err)
             return nullptr;
-        const auto condVarType = cond->GetVarType();
-        if (!IsValidCastType(condVarType))
-        {
-            err = AnalyseError("invalid switch condition expression type:" + std::to_string(condVarType), token);
-            return nullptr;
-        }
 
         token = ReadToken();
         if (token.GetType() != TokenType::S_RBRACES)
@@ -521,7 +477,7 @@ namespace c0
             token.GetType() == TokenType::R_CASE || token.GetType() == TokenType::R_DEFAULT;
             token = PeekToken())
         {
-            auto stmt = AnalyseLabeledStmt(parent, err, retType, canContinue);
+            auto stmt = AnalyseLabeledStmt(parent, err, canContinue);
             if (err)
                 return nullptr;
 
@@ -544,7 +500,7 @@ namespace c0
             return nullptr;
         }
 
-        auto switchptr = std::make_shared<SwitchStmtAST>(parent, cond);
+        auto switchptr = NewAST<SwitchStmtAST>(switchPos, parent, cond);
         switchptr->GetExpr()->SetParent(switchptr);
         for (const auto& stmt : caseStmts)
         {
@@ -559,15 +515,16 @@ namespace c0
          'case' (<integer-literal>|<char-literal>) ':' <statement>
         |'default' ':' <statement>
     */
-    StmtASTPtr Analyser::AnalyseLabeledStmt(ASTPtr parent, AnalyseError& err, VarType retType, bool canContinue)
+    StmtASTPtr Analyser::AnalyseLabeledStmt(ASTPtr parent, AnalyseError& err, bool canContinue)
     {
         auto isCase = false;
         int_t i;
 
+        const auto labelPos = _cur;
         auto token = ReadToken();
         if (token.GetType() == TokenType::R_CASE)
         {
-            auto expr = AnalyseExpr(parent, err, true);
+            auto expr = AnalyseExpr(parent, err);
             if (err)
                 return nullptr;
             if (expr->GetASTType() == ASTType::IntExpr)
@@ -605,14 +562,14 @@ namespace c0
             return nullptr;
         }
 
-        auto stmt = AnalyseStmt(parent, err, retType, true, canContinue, nullptr);
+        auto stmt = AnalyseStmt(parent, err, true, canContinue, nullptr);
         if (err)
             return nullptr;
 
         if (!isCase)
             return stmt;
 
-        auto caseStmt = std::make_shared<LabeledStmtAST>(parent, i, stmt);
+        auto caseStmt = NewAST<LabeledStmtAST>(labelPos, parent, i, stmt);
         caseStmt->GetStmt()->SetParent(caseStmt);
         return caseStmt;
     }
@@ -620,8 +577,9 @@ namespace c0
     /*
     'while' '(' <condition> ')' <statement>
     */
-    WhileStmtASTPtr Analyser::AnalyseWhileStmt(ASTPtr parent, AnalyseError& err, VarType retType)
+    WhileStmtASTPtr Analyser::AnalyseWhileStmt(ASTPtr parent, AnalyseError& err)
     {
+        const auto whilePos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::R_WHILE)
         {
@@ -646,12 +604,12 @@ namespace c0
             return nullptr;
         }
 
-        auto stmt = AnalyseStmt(parent, err, retType, true, true);
+        auto stmt = AnalyseStmt(parent, err, true, true);
         if (err)
             return nullptr;
         if (nullptr == stmt)
-            stmt = std::make_shared<EmptyStmtAST>(parent);
-        auto tmp = std::make_shared<WhileStmtAST>(parent, cond, stmt);
+            stmt = NewAST<EmptyStmtAST>(_cur - 1, parent);
+        auto tmp = NewAST<WhileStmtAST>(whilePos, parent, cond, stmt);
         tmp->GetCond()->SetParent(tmp);
         tmp->GetStmt()->SetParent(tmp);
         return tmp;
@@ -660,8 +618,9 @@ namespace c0
     /*
     'do' <statement> 'while' '(' <condition> ')' ';'
     */
-    DoStmtASTPtr Analyser::AnalyseDoStmt(ASTPtr parent, AnalyseError& err, VarType retType)
+    DoStmtASTPtr Analyser::AnalyseDoStmt(ASTPtr parent, AnalyseError& err)
     {
+        const auto doPos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::R_DO)
         {
@@ -669,11 +628,11 @@ namespace c0
             return nullptr;
         }
 
-        auto stmt = AnalyseStmt(parent, err, retType, true, true);
+        auto stmt = AnalyseStmt(parent, err, true, true);
         if (err)
             return nullptr;
         if (nullptr == stmt)
-            stmt = std::make_shared<EmptyStmtAST>(parent);
+            stmt = NewAST<EmptyStmtAST>(_cur - 1, parent);
 
         token = ReadToken();
         if (token.GetType() != TokenType::R_WHILE)
@@ -700,7 +659,7 @@ namespace c0
             return nullptr;
         }
 
-        auto tmp = std::make_shared<DoStmtAST>(parent, stmt, cond);
+        auto tmp = NewAST<DoStmtAST>(doPos, parent, stmt, cond);
         tmp->GetStmt()->SetParent(tmp);
         tmp->GetCond()->SetParent(tmp);
         return tmp;
@@ -713,8 +672,9 @@ namespace c0
     <for-update-expression> ::=
         (<assignment-expression>|<function-call>){','(<assignment-expression>|<function-call>)}
     */
-    ForStmtASTPtr Analyser::AnalyseForStmt(ASTPtr parent, AnalyseError& err, VarType retType)
+    ForStmtASTPtr Analyser::AnalyseForStmt(ASTPtr parent, AnalyseError& err)
     {
+        const auto forPos = _cur;
         auto token = ReadToken();
         if (token.GetType() != TokenType::R_FOR)
         {
@@ -728,7 +688,7 @@ namespace c0
             err = AnalyseError("expect '(' after 'for'", token);
             return nullptr;
         }
-        auto forptr = std::make_shared<ForStmtAST>(parent);
+        auto forptr = NewAST<ForStmtAST>(forPos, parent);
 
         for (token = PeekToken();
             token.GetType() != TokenType::S_SEMICOLON;
@@ -758,9 +718,9 @@ namespace c0
             _cur = readPos;
             err = AnalyseError();
 
-            auto left = std::make_shared<IntExprAST>(forptr, 1);
-            auto right = std::make_shared<IntExprAST>(forptr, 0);
-            cond = std::make_shared<BinaryExprAST>(forptr, left, BinaryType::NotEqual, right);
+            auto left = NewAST<IntExprAST>(readPos, forptr, 1);
+            auto right = NewAST<IntExprAST>(readPos, forptr, 0);
+            cond = NewAST<BinaryExprAST>(readPos, forptr, left, BinaryType::NotEqual, right, false);
             cond->GetLeftExpr()->SetParent(cond);
             cond->GetRightExpr()->SetParent(cond);
         }
@@ -784,11 +744,9 @@ namespace c0
                 err = AnalyseError("invalid for update express", token);
                 return nullptr;
             }
-            const auto name = token.GetString();
-
             ExprASTPtr expr;
-            if (parent->GetSymbolType(name, true) == SymbolType::Func)
-                expr = AnalyseFuncCallExpr(forptr, err, false);
+            if (GetIdentLookahead(PeekToken(1).GetType()) == Lookahead::FuncCall)
+                expr = AnalyseFuncCallExpr(forptr, err);
             else
                 expr = AnalyseAssignExpr(forptr, err);
             if (err)
@@ -807,11 +765,11 @@ namespace c0
             return nullptr;
         }
 
-        auto body = AnalyseStmt(forptr, err, retType, true, true);
+        auto body = AnalyseStmt(forptr, err, true, true);
         if (err)
             return nullptr;
         if (nullptr == body)
-            body = std::make_shared<EmptyStmtAST>(forptr);
+            body = NewAST<EmptyStmtAST>(_cur - 1, forptr);
         forptr->SetBody(body);
 
         return forptr;
@@ -841,7 +799,7 @@ namespace c0
             return nullptr;
         }
 
-        return std::make_shared<BreakStmtAST>(parent);
+        return NewAST<BreakStmtAST>(_cur - 2, parent);
     }
 
     /*
@@ -868,13 +826,13 @@ namespace c0
             return nullptr;
         }
 
-        return std::make_shared<ContinueStmtAST>(parent);
+        return NewAST<ContinueStmtAST>(_cur - 2, parent);
     }
 
     /*
     <return-statement> ::= 'return' [<expression>] ';'
     */
-    ReturnStmtASTPtr Analyser::AnalyseReturnStmt(ASTPtr parent, AnalyseError& err, VarType retType)
+    ReturnStmtASTPtr Analyser::AnalyseReturnStmt(ASTPtr parent, AnalyseError& err)
     {
         auto token = ReadToken();
         if (token.GetType() != TokenType::R_RETURN)
@@ -883,21 +841,12 @@ namespace c0
             return nullptr;
         }
 
-        auto ret = std::make_shared<ReturnStmtAST>(parent);
+        auto ret = NewAST<ReturnStmtAST>(_cur - 1, parent);
 
         token = PeekToken();
         if (token.GetType() != TokenType::S_SEMICOLON)
         {
-            if (VarType::Void == retType)
-            {
-                err = AnalyseError("void function cannot return any value", token);
-                return ret;
-            }
-            auto expr = AnalyseExpr(parent, err, false);
-            if (err)
-                return nullptr;
-
-            expr = CheckInexplicitTypeCast(parent, err, token, expr, retType, "");
+            auto expr = AnalyseExpr(ret, err);
             if (err)
                 return nullptr;
 
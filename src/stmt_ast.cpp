@@ -47,12 +47,18 @@ namespace c0
 
     SymbolType BlockStmtAST::GetSymbolType(const str_t& s, bool recusive) const
     {
+        DeclASTPtr decl = nullptr;
+        if (FindInSymbolTable(_symbols, s, recusive, decl))
+            return GetDeclSymbolType(decl);
         GET_SYMBOLTYPE_HELPER(_vars);
         return DefaultGetSymbolTypeImpl(s, recusive);
     }
 
     ASTPtr BlockStmtAST::GetSymbol(const str_t& s, bool recusive) const
     {
+        DeclASTPtr decl = nullptr;
+        if (FindInSymbolTable(_symbols, s, recusive, decl))
+            return decl;
         GET_SYMBOL_HELPER(_vars);
         return DefaultGetSymbolImpl(s, recusive);
     }
@@ -38,9 +38,13 @@ namespace c0
         const VarDeclASTPtrList& GetVars() const { return _vars; }
         const StmtASTPtrList& GetStmts() const { return _stmts; }
 
+        // set by semantic analyse when the scope of the block is entered
+        void SetSymbolTable(const SymbolTable* symbols) { _symbols = symbols; }
+
     private:
         VarDeclASTPtrList _vars;
         StmtASTPtrList _stmts;
+        const SymbolTable* _symbols = nullptr;
     };
 
     class CondStmtAST : public StmtAST
@@ -85,9 +89,12 @@ namespace c0
         bool Accept(ASTVisitor& visitor) const override;
 
         const str_t& GetName() const { return _name; }
+        DeclASTPtr GetDecl() const { return _decl; }
+        void SetDecl(DeclASTPtr decl) { _decl = decl; }
 
     private:
         const str_t _name;
+        DeclASTPtr _decl = nullptr;   // resolved by semantic analyse
     };
 
     class AssignStmtAST : public StmtAST
@@ -103,11 +110,15 @@ namespace c0
         bool Accept(ASTVisitor& visitor) const override;
 
         const str_t& GetName() const { return _name; }
+        DeclASTPtr GetDecl() const { return _decl; }
+        void SetDecl(DeclASTPtr decl) { _decl = decl; }
         const ExprASTPtr& GetExpr() const { return _expr; }
+        void SetExpr(ExprASTPtr ptr) { _expr = ptr; }
 
     private:
         const str_t _name;
-        const ExprASTPtr _expr;
+        DeclASTPtr _decl = nullptr;   // resolved by semantic analyse
+        ExprASTPtr _expr;
     };
 
     class FuncCallStmtAST : public StmtAST
@@ -116,15 +127,19 @@ namespace c0
         FuncCallStmtAST(ASTPtr parent, str_t name) : StmtAST(parent, ASTType::FuncCallStmt), _name(name) {}
 
         void AddParam(ExprASTPtr ptr) { _params.push_back(ptr); }
+        void SetParam(std::size_t i, ExprASTPtr ptr) { _params[i] = ptr; }
 
         std::string ToString() const override;
         bool Accept(ASTVisitor& visitor) const override;
 
         const str_t& GetName() const { return _name; }
+        DeclASTPtr GetDecl() const { return _decl; }
+        void SetDecl(DeclASTPtr decl) { _decl = decl; }
         const ExprASTPtrList& GetParams() const { return _params; }
 
     private:
         const str_t _name;
+        DeclASTPtr _decl = nullptr;   // resolved by semantic analyse
         ExprASTPtrList _params;
     };
 
@@ -151,7 +166,7 @@ namespace c0
     private:
         const BinaryExprASTPtr _ifcond;
         const StmtASTPtr _ifstmt;
-        StmtASTPtr _elsestmt;
+        StmtASTPtr _elsestmt = nullptr;
     };
 
     class SwitchStmtAST : public CondStmtAST
@@ -256,10 +271,10 @@ namespace c0
 
     private:
         AssignExprASTPtrList _initExprs;
-        BinaryExprASTPtr _cond;
+        BinaryExprASTPtr _cond = nullptr;
         ExprASTPtrList _updateExprs;
 
-        StmtASTPtr _body;
+        StmtASTPtr _body = nullptr;
     };
 
     class BreakStmtAST : public JumpStmtAST
@@ -293,6 +308,6 @@ namespace c0
         const ExprASTPtr& GetExpr() const { return _expr; }
 
     private:
-        ExprASTPtr _expr;
+        ExprASTPtr _expr = nullptr;
     };
 }
@@ -0,0 +1,373 @@
+#include "type_checker.h"
+
+namespace c0
+{
+    namespace
+    {
+        // binding of semantic analyse, or the symbol found by name in a tree only parsed
+        template<typename T>
+        DeclASTPtr FindDecl(const T& ast)
+        {
+            if (nullptr != ast.GetDecl())
+                return ast.GetDecl();
+            const auto symbol = ast.GetSymbol(ast.GetName(), true);
+            if (nullptr == symbol
+                || (symbol->GetASTType() != ASTType::VarDecl && symbol->GetASTType() != ASTType::FuncDecl))
+                return nullptr;
+            return static_cast<DeclASTPtr>(symbol);
+        }
+    }
+
+    bool TypeChecker::Check(FileASTPtr file, AnalyseErrorList& errs)
+    {
+        const auto count = errs.size();
+        for (const auto& var : file->GetVars())
+            CheckDecl(file, var, errs);
+        for (const auto& func : file->GetFuncs())
+            CheckDecl(file, func, errs);
+        return errs.size() == count;
+    }
+
+    bool TypeChecker::CheckDecl(FileASTPtr file, DeclASTPtr decl, AnalyseErrorList& errs)
+    {
+        _context = &file->GetContext();
+        _errs = &errs;
+        const auto count = errs.size();
+
+        if (decl->GetASTType() == ASTType::FuncDecl)
+            CheckFuncDecl(static_cast<FuncDeclASTPtr>(decl));
+        else
+            CheckVarDecl(static_cast<VarDeclASTPtr>(decl));
+
+        _errs = nullptr;
+        return errs.size() == count;
+    }
+
+    void TypeChecker::CheckVarDecl(VarDeclASTPtr var)
+    {
+        if (!var->HasExpr())
+            return;
+
+        const auto type = CheckExpr(var->GetExpr());
+        var->SetExpr(Convert(var->GetParent(), var->GetExpr(), type, var->GetVarType(),
+            GetToken(*var, 1), "invalid variable declare, "));
+    }
+
+    void TypeChecker::CheckFuncDecl(FuncDeclASTPtr func)
+    {
+        _retType = func->GetVarType();
+        if (nullptr != func->GetBlockStmt())
+            CheckBlockStmt(func->GetBlockStmt());
+    }
+
+    //-------------------------------------------------------------------------
+
+    void TypeChecker::CheckStmt(StmtASTPtr stmt)
+    {
+        if (nullptr == stmt)
+            return;
+
+        switch (stmt->GetASTType())
+        {
+        case ASTType::BlockStmt:
+            CheckBlockStmt(static_cast<BlockStmtASTPtr>(stmt));
+            break;
+
+        case ASTType::PrintStmt:
+            for (const auto& param : static_cast<PrintStmtASTPtr>(stmt)->GetParams())
+                CheckExpr(param);
+            break;
+
+        case ASTType::AssignStmt:
+            CheckAssignStmt(static_cast<AssignStmtASTPtr>(stmt));
+            break;
+
+        case ASTType::FuncCallStmt:
+            CheckFuncCall(static_cast<FuncCallStmtASTPtr>(stmt), false, "function call statement");
+            break;
+
+        case ASTType::IfStmt:
+        {
+            auto ifptr = static_cast<IfStmtASTPtr>(stmt);
+            CheckExpr(ifptr->GetIfCond());
+            CheckStmt(ifptr->GetIFStmt());
+            CheckStmt(ifptr->GetElseStmt());
+            break;
+        }
+
+        case ASTType::SwitchStmt:
+            CheckSwitchStmt(static_cast<SwitchStmtASTPtr>(stmt));
+            break;
+
+        case ASTType::LabeledStmt:
+            CheckStmt(static_cast<LabeledStmtASTPtr>(stmt)->GetStmt());
+            break;
+
+        case ASTType::WhileStmt:
+        {
+            auto whileptr = static_cast<WhileStmtASTPtr>(stmt);
+            CheckExpr(whileptr->GetCond());
+            CheckStmt(whileptr->GetStmt());
+            break;
+        }
+
+        case ASTType::DoStmt:
+        {
+            auto doptr = static_cast<DoStmtASTPtr>(stmt);
+            CheckStmt(doptr->GetStmt());
+            CheckExpr(doptr->GetCond());
+            break;
+        }
+
+        case ASTType::ForStmt:
+            CheckForStmt(static_cast<ForStmtASTPtr>(stmt));
+            break;
+
+        case ASTType::ReturnStmt:
+            CheckReturnStmt(static_cast<ReturnStmtASTPtr>(stmt));
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void TypeChecker::CheckBlockStmt(BlockStmtASTPtr block)
+    {
+        for (const auto& var : block->GetVars())
+            CheckVarDecl(var);
+        for (const auto& stmt : block->GetStmts())
+            CheckStmt(stmt);
+    }
+
+    void TypeChecker::CheckAssignStmt(AssignStmtASTPtr assign)
+    {
+        const auto decl = FindDecl(*assign);
+        const auto type = CheckExpr(assign->GetExpr());
+        if (nullptr == decl || decl->GetASTType() != ASTType::VarDecl)
+        {
+            AddError("cannot find variable in assignment statement", GetToken(*assign));
+            return;
+        }
+        assign->SetExpr(Convert(assign, assign->GetExpr(), type, decl->GetVarType(),
+            GetToken(*assign, 1), "invalid assignment statement, "));
+    }
+
+    void TypeChecker::CheckSwitchStmt(SwitchStmtASTPtr switchptr)
+    {
+        const auto type = CheckExpr(switchptr->GetExpr());
+        if (VarType::Nul != type && !IsValidCastType(type))
+        {
+            AddError("invalid switch condition expression type:" + std::to_string(type),
+                GetToken(*switchptr, 1));
+        }
+
+        for (const auto& stmt : switchptr->GetStmts())
+            CheckStmt(stmt);
+    }
+
+    void TypeChecker::CheckForStmt(ForStmtASTPtr forptr)
+    {
+        for (const auto& expr : forptr->GetInitExprs())
+            CheckAssignExpr(expr);
+        CheckExpr(forptr->GetCond());
+        // function called for update may have no return
+        for (const auto& expr : forptr->GetUpdateExprs())
+            CheckExpr(expr, false);
+        CheckStmt(forptr->GetBody());
+    }
+
+    void TypeChecker::CheckReturnStmt(ReturnStmtASTPtr ret)
+    {
+        if (nullptr == ret->GetExpr())
+            return;
+
+        const auto token = GetToken(*ret, 1);
+        if (VarType::Void == _retType)
+        {
+            AddError("void function cannot return any value", token);
+            CheckExpr(ret->GetExpr());
+            return;
+        }
+        const auto type = CheckExpr(ret->GetExpr());
+        ret->SetExpr(Convert(ret, ret->GetExpr(), type, _retType, token, ""));
+    }
+
+    //-------------------------------------------------------------------------
+
+    VarType TypeChecker::CheckExpr(ExprASTPtr expr, bool isNeedValue)
+    {
+        switch (expr->GetASTType())
+        {
+        case ASTType::BinaryExpr:
+            return CheckBinaryExpr(static_cast<BinaryExprASTPtr>(expr));
+
+        case ASTType::CastExpr:
+        {
+            auto cast = static_cast<CastExprASTPtr>(expr);
+            const auto type = CheckExpr(cast->GetExpr());
+            if (VarType::Nul != type && !IsVarTypeCastable(type, cast->GetVarType()))
+            {
+                AddError("can not cast type from '" + std::to_string(type) + "' to '"
+                    + std::to_string(cast->GetVarType()) + "'", GetToken(*cast, 1));
+            }
+            return cast->GetVarType();
+        }
+
+        case ASTType::UnaryExpr:
+        {
+            auto unary = static_cast<UnaryExprASTPtr>(expr);
+            const auto type = CheckExpr(unary->GetExpr());
+            if (VarType::Str == type)
+            {
+                AddError("cannot apply unary operator on string", GetToken(*unary));
+                return VarType::Nul;
+            }
+            unary->SetVarType(type);
+            return type;
+        }
+
+        case ASTType::BraceExpr:
+        {
+            auto brace = static_cast<BraceExprASTPtr>(expr);
+            const auto type = CheckExpr(brace->GetExpr());
+            brace->SetVarType(type);
+            return type;
+        }
+
+        case ASTType::IdentExpr:
+        {
+            auto ident = static_cast<IdentExprASTPtr>(expr);
+            const auto decl = FindDecl(*ident);
+            if (nullptr == decl || decl->GetASTType() != ASTType::VarDecl)
+            {
+                AddError("unknown identifier in primary expression", GetToken(*ident));
+                return VarType::Nul;
+            }
+            ident->SetVarType(decl->GetVarType());
+            return decl->GetVarType();
+        }
+
+        case ASTType::AssignExpr:
+            return CheckAssignExpr(static_cast<AssignExprASTPtr>(expr));
+
+        case ASTType::FuncCallExpr:
+        {
+            const auto type = CheckFuncCall(static_cast<FuncCallExprASTPtr>(expr), isNeedValue, "function call expression");
+            if (VarType::Nul != type)
+                expr->SetVarType(type);
+            return type;
+        }
+
+        default:
+            return expr->GetVarType();
+        }
+    }
+
+    VarType TypeChecker::CheckBinaryExpr(BinaryExprASTPtr expr)
+    {
+        const auto left = CheckExpr(expr->GetLeftExpr());
+        const auto right = CheckExpr(expr->GetRightExpr());
+        if (VarType::Nul == left || VarType::Nul == right)
+            return VarType::Nul;
+
+        // condition without relational operator compares with zero of its own type, once
+        auto rightType = right;
+        if (!expr->IsExplicit() && VarType::Float == left && VarType::Float != right)
+        {
+            auto zero = _context->New<FloatExprAST>(expr, 0.0);
+            zero->SetTokenIndex(expr->GetRightExpr()->GetTokenIndex());
+            expr->SetRightExpr(zero);
+            rightType = VarType::Float;
+        }
+
+        const auto token = GetToken(*expr);
+        const auto type = MergeVarType(left, rightType);
+        const auto count = _errs->size();
+        expr->SetLeftExpr(Convert(expr, expr->GetLeftExpr(), left, type, token, ""));
+        expr->SetRightExpr(Convert(expr, expr->GetRightExpr(), rightType, type, token, ""));
+        if (_errs->size() != count)
+            return VarType::Nul;
+        expr->SetVarType(type);
+        return type;
+    }
+
+    VarType TypeChecker::CheckAssignExpr(AssignExprASTPtr expr)
+    {
+        const auto decl = FindDecl(*expr);
+        const auto type = CheckExpr(expr->GetExpr());
+        if (nullptr == decl || decl->GetASTType() != ASTType::VarDecl)
+        {
+            AddError("cannot find variable in assignment expression", GetToken(*expr));
+            return VarType::Nul;
+        }
+        expr->SetExpr(Convert(expr, expr->GetExpr(), type, decl->GetVarType(),
+            GetToken(*expr, 1), "invalid assignment expression, "));
+        expr->SetVarType(decl->GetVarType());
+        return decl->GetVarType();
+    }
+
+    template<typename Call>
+    VarType TypeChecker::CheckFuncCall(Call* call, bool isNeedValue, const str_t& where)
+    {
+        // errors of the callee come first, in the order semantic analyse finds them
+        const auto decl = FindDecl(*call);
+        const auto isFunc = nullptr != decl && decl->GetASTType() == ASTType::FuncDecl;
+        if (!isFunc)
+            AddError("identifier is not a function name in " + where, GetToken(*call));
+        else if (isNeedValue && VarType::Void == decl->GetVarType())
+            AddError("function has no return in " + where, GetToken(*call));
+
+        const auto& params = call->GetParams();
+        std::vector<VarType> types;
+        types.reserve(params.size());
+        for (const auto& param : params)
+            types.push_back(CheckExpr(param));
+        if (!isFunc || (isNeedValue && VarType::Void == decl->GetVarType()))
+            return VarType::Nul;
+
+        const auto func = static_cast<FuncDeclASTPtr>(decl);
+
+        const auto& declParams = func->GetParams();
+        if (params.size() != declParams.size())
+        {
+            AddError("parameter number mismatch in " + where + ", need " + std::to_string(declParams.size())
+                + ", have " + std::to_string(params.size()), GetToken(*call));
+        }
+        else
+        {
+            for (std::size_t i = 0, N = params.size(); i < N; ++i)
+            {
+                call->SetParam(i, Convert(call, params[i], types[i], declParams[i]->GetVarType(), GetToken(*call),
+                    "for " + std::to_string(i) + "th function param in " + where + ", "));
+            }
+        }
+        return func->GetVarType();
+    }
+
+    ExprASTPtr TypeChecker::Convert(ASTPtr parent, ExprASTPtr expr, VarType from, VarType to,
+        const Token& token, const str_t& extralog)
+    {
+        if (VarType::Nul == from || from == to)
+            return expr;
+
+        if (!IsVarTypeCastable(from, to))
+        {
+            AddError(extralog + "cannot inexplicit cast type from '" + std::to_string(from) + "' to '"
+                + std::to_string(to) + "'", token);
+            return expr;
+        }
+        auto cast = _context->New<CastExprAST>(parent, expr, to, false);
+        cast->SetTokenIndex(expr->GetTokenIndex());
+        expr->SetParent(cast);
+        return cast;
+    }
+
+    Token TypeChecker::GetToken(const AST& ast, std::size_t offset) const
+    {
+        const auto pos = ast.GetTokenIndex() + offset;
+        if (pos >= _tokens.size())
+            return Token();
+        return _tokens[pos];
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "analyser.h"
+
+namespace c0
+{
+    /*
+    type checking of a whole file as a pass of its own, on a tree from
+    Analyser::Parse or one analysed already. expression types are set,
+    implicit casts are inserted in place in the same walk, and every type
+    error is collected instead of stopping at the first, e.g.
+
+        TypeChecker checker(tokens);
+        AnalyseErrorList errs;
+        if (!checker.Check(file, errs)) ... errs ...
+
+    an expression with an error has type Nul and its parent is not checked
+    again, so one mistake is reported once. identifiers not bound by
+    semantic analyse are looked up with GetSymbol. a tree analysed already
+    has all its casts and is left as it is.
+
+    this is the only place of the typing rules, SemaAnalyser binds the names
+    of a declaration and runs CheckDecl on it.
+    */
+    class TypeChecker
+    {
+    public:
+        TypeChecker(const TokenList& tokens) : _tokens(tokens) {}
+
+        // true if no error is found
+        bool Check(FileASTPtr file, AnalyseErrorList& errs);
+
+        // one top-level declaration of file, SemaAnalyser checks each one it has bound
+        bool CheckDecl(FileASTPtr file, DeclASTPtr decl, AnalyseErrorList& errs);
+
+    private:
+        void CheckVarDecl(VarDeclASTPtr var);
+        void CheckFuncDecl(FuncDeclASTPtr func);
+
+        void CheckStmt(StmtASTPtr stmt);
+        void CheckBlockStmt(BlockStmtASTPtr block);
+        void CheckAssignStmt(AssignStmtASTPtr assign);
+        void CheckSwitchStmt(SwitchStmtASTPtr switchptr);
+        void CheckForStmt(ForStmtASTPtr forptr);
+        void CheckReturnStmt(ReturnStmtASTPtr ret);
+
+        VarType CheckExpr(ExprASTPtr expr, bool isNeedValue = true);
+        VarType CheckBinaryExpr(BinaryExprASTPtr expr);
+        VarType CheckAssignExpr(AssignExprASTPtr expr);
+
+        // parameters of a function call statement or expression
+        template<typename Call>
+        VarType CheckFuncCall(Call* call, bool isNeedValue, const str_t& where);
+
+        // expr of type from, converted to type to by an implicit cast if needed
+        ExprASTPtr Convert(ASTPtr parent, ExprASTPtr expr, VarType from, VarType to,
+            const Token& token, const str_t& extralog);
+
+        void AddError(const str_t& err, const Token& token) { _errs->emplace_back(err, token); }
+        Token GetToken(const AST& ast, std::size_t offset = 0) const;
+
+    private:
+        const TokenList& _tokens;
+        ASTContext* _context = nullptr;     // of the file checked, casts are created in
+        AnalyseErrorList* _errs = nullptr;
+        VarType _retType = VarType::Nul;
+    };
+}
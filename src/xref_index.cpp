@@ -0,0 +1,257 @@
+#include "xref_index.h"
+#include "ast_visitor.h"
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+
+namespace c0
+{
+    namespace
+    {
+        // declarations in tree order, and the uses bound to them
+        class XRefCollector : public StaticASTVisitor<XRefCollector>
+        {
+        public:
+            void VisitVarDecl(const VarDeclAST& ast)
+            {
+                AddDecl(ast);
+                VisitChildren(ast);
+            }
+            void VisitFuncDecl(const FuncDeclAST& ast)
+            {
+                AddDecl(ast);
+                VisitChildren(ast);
+            }
+
+            void VisitIdentExpr(const IdentExprAST& ast) { AddUse(ast, ast.GetDecl()); }
+            void VisitAssignExpr(const AssignExprAST& ast)
+            {
+                AddUse(ast, ast.GetDecl());
+                VisitChildren(ast);
+            }
+            void VisitFuncCallExpr(const FuncCallExprAST& ast)
+            {
+                AddUse(ast, ast.GetDecl());
+                VisitChildren(ast);
+            }
+            void VisitScanStmt(const ScanStmtAST& ast) { AddUse(ast, ast.GetDecl()); }
+            void VisitAssignStmt(const AssignStmtAST& ast)
+            {
+                AddUse(ast, ast.GetDecl());
+                VisitChildren(ast);
+            }
+            void VisitFuncCallStmt(const FuncCallStmtAST& ast)
+            {
+                AddUse(ast, ast.GetDecl());
+                VisitChildren(ast);
+            }
+
+            std::vector<const DeclAST*> decls;
+            std::unordered_map<const DeclAST*, std::uint32_t> declIndex;
+            std::vector<std::pair<std::size_t, const DeclAST*>> uses;  // token of use and its declaration
+
+        private:
+            void AddDecl(const DeclAST& ast)
+            {
+                declIndex.emplace(&ast, static_cast<std::uint32_t>(decls.size()));
+                decls.push_back(&ast);
+            }
+            void AddUse(const AST& ast, DeclASTPtr decl)
+            {
+                if (nullptr != decl)
+                    uses.emplace_back(ast.GetTokenIndex(), decl);
+            }
+        };
+
+        const std::uint32_t XRefMagic = 0x52583043;     // "C0XR"
+        const std::uint32_t XRefVersion = 1;
+
+        void WriteU32(std::ostream& os, std::size_t value)
+        {
+            char bytes[4];
+            for (int i = 0; i < 4; ++i)
+                bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+            os.write(bytes, sizeof(bytes));
+        }
+
+        bool ReadU32(std::istream& is, std::uint32_t& value)
+        {
+            unsigned char bytes[4];
+            if (!is.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+                return false;
+            value = 0;
+            for (int i = 0; i < 4; ++i)
+                value |= std::uint32_t(bytes[i]) << (8 * i);
+            return true;
+        }
+
+        // read as the bytes arrive, a broken size fails at the end of stream before allocating it
+        bool ReadString(std::istream& is, str_t& s)
+        {
+            std::uint32_t size = 0;
+            if (!ReadU32(is, size))
+                return false;
+            s.clear();
+            char buffer[256];
+            while (s.size() < size)
+            {
+                const auto n = std::min<std::size_t>(sizeof(buffer), size - s.size());
+                if (!is.read(buffer, n))
+                    return false;
+                s.append(buffer, n);
+            }
+            return true;
+        }
+
+        void WriteRange(std::ostream& os, const posrange_t& range)
+        {
+            WriteU32(os, range.first.first);
+            WriteU32(os, range.first.second);
+            WriteU32(os, range.second.first);
+            WriteU32(os, range.second.second);
+        }
+
+        bool ReadRange(std::istream& is, posrange_t& range)
+        {
+            std::uint32_t values[4];
+            for (auto& value : values)
+            {
+                if (!ReadU32(is, value))
+                    return false;
+            }
+            range = posrange_t(pos_t(values[0], values[1]), pos_t(values[2], values[3]));
+            return true;
+        }
+    }
+
+    const std::size_t XRefIndex::NoDecl;
+
+    XRefIndex::XRefIndex(const FileAST& file, const TokenList& tokens)
+    {
+        XRefCollector collector;
+        collector.Visit(file);
+
+        const auto getRange = [&](std::size_t token)
+        {
+            return token < tokens.size() ? tokens[token].GetPosRange() : posrange_t();
+        };
+
+        _decls.reserve(collector.decls.size());
+        for (std::size_t i = 0, N = collector.decls.size(); i < N; ++i)
+        {
+            const auto decl = collector.decls[i];
+            const auto& name = decl->GetASTType() == ASTType::FuncDecl
+                ? static_cast<const FuncDeclAST*>(decl)->GetName()
+                : static_cast<const VarDeclAST*>(decl)->GetName();
+            _decls.push_back({ name, decl->GetDeclType(), getRange(decl->GetTokenIndex()) });
+            _refs.push_back({ _decls.back().range, static_cast<std::uint32_t>(i) });
+        }
+
+        // uses grouped by declaration with a counting sort, then sorted by position in each group
+        std::vector<Ref> uses;
+        uses.reserve(collector.uses.size());
+        _useOffsets.assign(_decls.size() + 1, 0);
+        for (const auto& use : collector.uses)
+        {
+            const auto it = collector.declIndex.find(use.second);
+            if (it == collector.declIndex.end())
+                continue;
+            uses.push_back({ getRange(use.first), it->second });
+            ++_useOffsets[it->second + 1];
+        }
+        for (std::size_t i = 1; i < _useOffsets.size(); ++i)
+            _useOffsets[i] += _useOffsets[i - 1];
+
+        _uses.resize(uses.size());
+        auto next = _useOffsets;
+        for (const auto& use : uses)
+            _uses[next[use.decl]++] = use.range;
+        for (std::size_t i = 0, N = _decls.size(); i < N; ++i)
+            std::sort(_uses.begin() + _useOffsets[i], _uses.begin() + _useOffsets[i + 1]);
+
+        _refs.insert(_refs.end(), uses.begin(), uses.end());
+        std::sort(_refs.begin(), _refs.end(), [](const Ref& a, const Ref& b) { return a.range < b.range; });
+    }
+
+    std::size_t XRefIndex::FindDecl(const pos_t& pos) const
+    {
+        // last reference beginning at or before pos
+        auto it = std::upper_bound(_refs.begin(), _refs.end(), pos,
+            [](const pos_t& pos, const Ref& ref) { return pos < ref.range.first; });
+        if (it == _refs.begin())
+            return NoDecl;
+        --it;
+        if (!(pos < it->range.second))
+            return NoDecl;
+        return it->decl;
+    }
+
+    void XRefIndex::Save(std::ostream& os) const
+    {
+        WriteU32(os, XRefMagic);
+        WriteU32(os, XRefVersion);
+
+        WriteU32(os, _decls.size());
+        for (const auto& decl : _decls)
+        {
+            WriteU32(os, decl.name.size());
+            os.write(decl.name.data(), decl.name.size());
+            WriteU32(os, static_cast<std::uint32_t>(decl.type));
+            WriteRange(os, decl.range);
+        }
+
+        for (std::size_t i = 0, N = _decls.size(); i < N; ++i)
+        {
+            WriteU32(os, GetUseCount(i));
+            for (std::size_t j = 0, M = GetUseCount(i); j < M; ++j)
+                WriteRange(os, GetUse(i, j));
+        }
+    }
+
+    bool XRefIndex::Load(std::istream& is)
+    {
+        *this = XRefIndex();
+
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+        std::uint32_t count = 0;
+        if (!ReadU32(is, magic) || XRefMagic != magic || !ReadU32(is, version) || XRefVersion != version
+            || !ReadU32(is, count))
+            return false;
+
+        XRefIndex index;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            XRefDecl decl;
+            std::uint32_t type = 0;
+            if (!ReadString(is, decl.name) || !ReadU32(is, type) || type > std::uint32_t(DeclType::Func)
+                || !ReadRange(is, decl.range))
+                return false;
+            decl.type = DeclType(type);
+            index._refs.push_back({ decl.range, i });
+            index._decls.push_back(std::move(decl));
+        }
+
+        index._useOffsets.reserve(count + 1);
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::uint32_t uses = 0;
+            if (!ReadU32(is, uses))
+                return false;
+            for (std::uint32_t j = 0; j < uses; ++j)
+            {
+                posrange_t range;
+                if (!ReadRange(is, range))
+                    return false;
+                index._uses.push_back(range);
+                index._refs.push_back({ range, i });
+            }
+            index._useOffsets.push_back(static_cast<std::uint32_t>(index._uses.size()));
+        }
+
+        std::sort(index._refs.begin(), index._refs.end(), [](const Ref& a, const Ref& b) { return a.range < b.range; });
+        *this = std::move(index);
+        return true;
+    }
+}
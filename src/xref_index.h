@@ -0,0 +1,62 @@
+#pragma once
+#include "all_ast.h"
+#include "tokenizer.h"
+#include <iosfwd>
+
+namespace c0
+{
+    struct XRefDecl
+    {
+        str_t name;
+        DeclType type;
+        posrange_t range;       // of the name in the declaration
+    };
+
+    /*
+    cross references of an analysed file: every declaration with the name
+    ranges of all its uses, and every name range back to its declaration, so
+    that "go to definition" and "find references" are binary searches over
+    sorted arrays, without the tree. uses are the ones bound by semantic
+    analyse, an ast not analysed has declarations only. the index is saved
+    and loaded as a whole, e.g.
+
+        XRefIndex xref(*file, tokens);
+        const auto decl = xref.FindDecl(pos);
+        for (std::size_t i = 0, N = xref.GetUseCount(decl); i < N; ++i)
+            ... xref.GetUse(decl, i) ...
+    */
+    class XRefIndex
+    {
+    public:
+        static const std::size_t NoDecl = static_cast<std::size_t>(-1);
+
+        XRefIndex() = default;
+        XRefIndex(const FileAST& file, const TokenList& tokens);
+
+        std::size_t GetDeclCount() const { return _decls.size(); }
+        const XRefDecl& GetDecl(std::size_t decl) const { return _decls[decl]; }
+
+        // uses of decl sorted by position, its declaration not included
+        std::size_t GetUseCount(std::size_t decl) const { return _useOffsets[decl + 1] - _useOffsets[decl]; }
+        const posrange_t& GetUse(std::size_t decl, std::size_t i) const { return _uses[_useOffsets[decl] + i]; }
+
+        // declaration of the name at pos, which is its declaration or one of its uses, NoDecl if none
+        std::size_t FindDecl(const pos_t& pos) const;
+
+        void Save(std::ostream& os) const;
+        // false and left empty if the stream is not a saved index
+        bool Load(std::istream& is);
+
+    private:
+        struct Ref
+        {
+            posrange_t range;
+            std::uint32_t decl;
+        };
+
+        std::vector<XRefDecl> _decls;
+        std::vector<std::uint32_t> _useOffsets = { 0 };     // uses of decl i are [_useOffsets[i], _useOffsets[i + 1])
+        std::vector<posrange_t> _uses;
+        std::vector<Ref> _refs;     // declarations and uses sorted by position
+    };
+}
@@ -0,0 +1,1662 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include <analyser.h>
+#include <ast_attribute.h>
+#include <ast_visitor.h>
+#include <call_graph.h>
+#include <cfg.h>
+#include <const_evaluator.h>
+#include <definite_assignment.h>
+#include <dump_visitor.h>
+#include <flat_ast.h>
+#include <sema_analyser.h>
+#include <type_checker.h>
+#include <xref_index.h>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+TEST_SUITE_BEGIN("analyser");
+using namespace c0;
+
+namespace
+{
+    TokenList Tokenize(const std::string& s)
+    {
+        std::istringstream is(s);
+        Tokenizer tzer(is);
+        return tzer.All();
+    }
+
+    FileASTPtr Analyse(const std::string& s, AnalyseError& err)
+    {
+        Analyser ayer(Tokenize(s));
+        return ayer.Analyse(err);
+    }
+
+    class TokenIndexCollector : public ASTVisitor
+    {
+    public:
+        bool BegVisit(const AST& ast) override
+        {
+            indexes.push_back(ast.GetTokenIndex());
+            return true;
+        }
+        bool EndVisit(const AST&) override { return true; }
+
+        std::vector<std::size_t> indexes;
+    };
+
+    class IntExprCounter : public ASTVisitor
+    {
+    public:
+        bool BegVisit(const AST& ast) override
+        {
+            if (ast.GetASTType() == ASTType::IntExpr)
+                ++count;
+            return true;
+        }
+        bool EndVisit(const AST&) override { return true; }
+
+        std::size_t count = 0;
+    };
+
+    class StaticIntExprCounter : public StaticASTVisitor<StaticIntExprCounter>
+    {
+    public:
+        void VisitIntExpr(const IntExprAST&) { ++count; }
+
+        std::size_t count = 0;
+    };
+
+    // depth of every node, the file is 0
+    class DepthPass : public StaticASTVisitor<DepthPass>
+    {
+    public:
+        DepthPass(const FileAST& file) : depth(file, -1) {}
+
+        void Visit(const AST& ast)
+        {
+            depth[ast] = nullptr == ast.GetParent() ? 0 : depth[*ast.GetParent()] + 1;
+            StaticASTVisitor<DepthPass>::Visit(ast);
+        }
+
+        ASTAttribute<int> depth;
+    };
+
+    // value of constant int expressions
+    class ConstIntPass : public StaticASTVisitor<ConstIntPass>
+    {
+    public:
+        ConstIntPass(const FileAST& file) : isConst(file, 0), value(file, 0) {}
+
+        void VisitIntExpr(const IntExprAST& ast)
+        {
+            isConst[ast] = 1;
+            value[ast] = ast.GetInt();
+        }
+        void VisitBinaryExpr(const BinaryExprAST& ast)
+        {
+            VisitChildren(ast);
+            const auto& left = *ast.GetLeftExpr();
+            const auto& right = *ast.GetRightExpr();
+            if (!isConst[left] || !isConst[right])
+                return;
+            isConst[ast] = 1;
+            switch (ast.GetOT())
+            {
+            case BinaryType::Add: value[ast] = value[left] + value[right]; break;
+            case BinaryType::Sub: value[ast] = value[left] - value[right]; break;
+            case BinaryType::Mul: value[ast] = value[left] * value[right]; break;
+            default: isConst[ast] = 0; break;
+            }
+        }
+
+        ASTAttribute<char> isConst;
+        ASTAttribute<int_t> value;
+    };
+
+    class StaticNodeCounter : public StaticASTVisitor<StaticNodeCounter>
+    {
+    public:
+        void Visit(const AST& ast)
+        {
+            ++count;
+            StaticASTVisitor<StaticNodeCounter>::Visit(ast);
+        }
+
+        std::size_t count = 0;
+    };
+}
+
+TEST_CASE("forward function reference")
+{
+    std::string s = R"(
+int g = 1;
+
+int main()
+{
+    print(twice(g));
+    hello();
+    return 0;
+}
+
+void hello()
+{
+    print("hello");
+}
+
+int twice(int n)
+{
+    return n * 2;
+}
+)";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+
+    CHECK(!err);
+    REQUIRE(file != nullptr);
+    CHECK(file->GetVars().size() == 1);
+    REQUIRE(file->GetFuncs().size() == 3);
+    for (const auto& func : file->GetFuncs())
+        CHECK(func->GetBlockStmt() != nullptr);
+
+    // a global initializer cannot call a function, which could read the global before it is set
+    AnalyseError globalErr;
+    Analyse("int x = f(); int f() { return x; } int main() { return x; }", globalErr);
+    REQUIRE(globalErr);
+    CHECK(globalErr.GetError() == "function call in global variable initializer");
+
+    AnalyseError localErr;
+    Analyse("int x = 1; int f() { return x; } int main() { int y = f(); return y; }", localErr);
+    CHECK(!localErr);
+}
+
+TEST_CASE("mutual recursion")
+{
+    std::string s = R"(
+int even(int n)
+{
+    if (n == 0)
+        return 1;
+    return odd(n - 1);
+}
+
+int odd(int n)
+{
+    if (n == 0)
+        return 0;
+    return even(n - 1);
+}
+)";
+    AnalyseError err;
+    Analyse(s, err);
+    CHECK(!err);
+}
+
+TEST_CASE("function signature errors")
+{
+    AnalyseError err;
+    Analyse("void f() {} int f() { return 0; }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "function name repeated");
+
+    err = AnalyseError();
+    Analyse("int g; void g() {}", err);
+    CHECK(err);
+    CHECK(err.GetError() == "variable name repeated");
+
+    err = AnalyseError();
+    Analyse("int main() { return 0;", err);
+    CHECK(err);
+    CHECK(err.GetError() == "expect '}' at block end");
+
+    err = AnalyseError();
+    Analyse("int main() { return f(1); } int f() { return 0; }", err);
+    CHECK(err);
+}
+
+TEST_CASE("statement dispatch by lookahead")
+{
+    AnalyseError err;
+    Analyse("void f() { int x; x = 1; f(); x = g(x); } int g(int n) { return n; }", err);
+    CHECK(!err);
+
+    err = AnalyseError();
+    Analyse("void f() { int x; x; }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "expect '=' or '(' after identifier in statement");
+
+    err = AnalyseError();
+    Analyse("void f() { f = 1; }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "cannot find variable in assignment statement");
+
+    err = AnalyseError();
+    Analyse("void f() { int x; x(); }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "identifier is not a function name in function call statement");
+
+    err = AnalyseError();
+    Analyse("void f() { const int x = 1; x = 2; }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "cannot assign on const variable in assignment statement");
+
+    err = AnalyseError();
+    Analyse("void f() { scan(y); }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "cannot find variable in scan statement");
+
+    err = AnalyseError();
+    Analyse("const int x = 1; void f() { scan(x); }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "cannot scan into const variable");
+}
+
+TEST_CASE("incremental reanalyse function body")
+{
+    std::string olds = R"(
+int g = 1;
+
+int f(int n)
+{
+    return n + g;
+}
+
+int main()
+{
+    return f(2);
+}
+)";
+    std::string news = R"(
+int g = 1;
+
+int f(int n)
+{
+    return n * 2 + g;
+}
+
+int main()
+{
+    return f(2);
+}
+)";
+    const auto oldTokens = Tokenize(olds);
+    AnalyseError err;
+    auto file = Analyser(oldTokens).Analyse(err);
+    REQUIRE(!err);
+    const auto f = file->GetFuncs()[0];
+    const auto fblock = f->GetBlockStmt();
+    const auto mainblock = file->GetFuncs()[1]->GetBlockStmt();
+
+    // "n * 2 + g" replaced "n + g" at line 6
+    const posrange_t edit(pos_t(5, 13), pos_t(5, 18));
+    auto newfile = Analyser(Tokenize(news)).Reanalyse(file, oldTokens, edit, err);
+    CHECK(!err);
+    CHECK(newfile == file);
+    CHECK(file->GetFuncs()[0] == f);
+    CHECK(f->GetBlockStmt() != fblock);
+    CHECK(file->GetFuncs()[1]->GetBlockStmt() == mainblock);
+    CHECK(file->ToString() == Analyse(news, err)->ToString());
+}
+
+TEST_CASE("incremental reanalyse global variable")
+{
+    std::string olds = "int a = 1; int b = a; int main() { return b; }";
+    std::string news = "int a = 1; int b = a * 3; int main() { return b; }";
+    const auto oldTokens = Tokenize(olds);
+    AnalyseError err;
+    auto file = Analyser(oldTokens).Analyse(err);
+    REQUIRE(!err);
+    const auto b = file->GetVars()[1];
+    const auto mainblock = file->GetFuncs()[0]->GetBlockStmt();
+
+    const posrange_t edit(pos_t(0, 20), pos_t(0, 24));
+    Analyser(Tokenize(news)).Reanalyse(file, oldTokens, edit, err);
+    CHECK(!err);
+    CHECK(file->GetVars()[1] == b);
+    CHECK(b->GetExpr()->ToString() == "a * 3");
+    CHECK(file->GetFuncs()[0]->GetBlockStmt() == mainblock);
+
+    // later global variable is not visible
+    std::string bad = "int a = b; int b = 1; int main() { return b; }";
+    const posrange_t badedit(pos_t(0, 8), pos_t(0, 9));
+    Analyser(Tokenize(bad)).Reanalyse(file, Tokenize("int a = 1; int b = 1; int main() { return b; }"), badedit, err);
+    CHECK(err);
+}
+
+TEST_CASE("incremental reanalyse signature change")
+{
+    std::string olds = "int f(int n) { return n; } int main() { return f(1); }";
+    std::string news = "int f(int n, int m) { return n; } int main() { return f(1); }";
+    const auto oldTokens = Tokenize(olds);
+    AnalyseError err;
+    auto file = Analyser(oldTokens).Analyse(err);
+    REQUIRE(!err);
+
+    const posrange_t edit(pos_t(0, 11), pos_t(0, 18));
+    auto newfile = Analyser(Tokenize(news)).Reanalyse(file, oldTokens, edit, err);
+    CHECK(newfile != file);
+    CHECK(err);
+    CHECK(err.GetError().find("parameter number mismatch") == 0);
+}
+
+TEST_CASE("incremental reanalyse bounded")
+{
+    // the body of f alternates between two versions, each edit replaces it
+    const std::string texts[] = {
+        "int g = 1; int f(int n) { int a; { a = n + g; } return a; } int main() { return f(2); }",
+        "int g = 2; int f(int n) { int b; { b = n * g; } return b; } int main() { return f(2); }",
+    };
+    const posrange_t edit(pos_t(0, 8), pos_t(0, 53));
+    const TokenList tokens[] = { Tokenize(texts[0]), Tokenize(texts[1]) };
+
+    AnalyseError err;
+    auto file = Analyser(tokens[0]).Analyse(err);
+    REQUIRE(!err);
+    const auto nodes = file->GetContext().GetNodeCount();
+    const auto scopes = file->GetSymbolTable().GetScopeCount();
+
+    std::size_t rebuilds = 0;
+    for (std::size_t i = 1; i <= 1000; ++i)
+    {
+        AnalyseError editErr;
+        auto newfile = Analyser(tokens[i % 2]).Reanalyse(file, tokens[(i - 1) % 2], edit, editErr);
+        REQUIRE(!editErr);
+        if (newfile != file)
+            ++rebuilds;
+        file = newfile;
+        CHECK(file->GetContext().GetNodeCount() <= 3 * nodes);
+        CHECK(file->GetSymbolTable().GetScopeCount() <= 3 * scopes);
+    }
+    CHECK(rebuilds > 0);
+    CHECK(rebuilds < 1000 / 2);
+    CHECK(file->ToString() == Analyse(texts[0], err)->ToString());
+}
+
+TEST_CASE("incremental reanalyse undone")
+{
+    std::string olds = "int f(int n) { return n; } int main() { return f(1); }";
+    const auto oldTokens = Tokenize(olds);
+    AnalyseError err;
+    auto file = Analyser(oldTokens).Analyse(err);
+    REQUIRE(!err);
+    const auto f = file->GetFuncs()[0];
+    const auto fblock = f->GetBlockStmt();
+    const auto ret = fblock->GetStmts()[0]->GetTokenIndex();
+    const auto main = file->GetFuncs()[1]->GetTokenIndex();
+    const auto str = file->ToString();
+
+    // an error in the edited body, main after it was moved already
+    std::string bad = "int f(int n) { return n + x; } int main() { return f(1); }";
+    AnalyseError badErr;
+    auto badfile = Analyser(Tokenize(bad)).Reanalyse(file, oldTokens, posrange_t(pos_t(0, 22), pos_t(0, 27)), badErr);
+    CHECK(badErr);
+    CHECK(badfile == file);
+    CHECK(f->GetBlockStmt() == fblock);
+    CHECK(fblock->GetStmts()[0]->GetTokenIndex() == ret);
+    CHECK(file->GetFuncs()[1]->GetTokenIndex() == main);
+    CHECK(file->ToString() == str);
+
+    // the body of f is reanalysed before the signature change of main is found
+    std::string changed = "int f(int n) { return n * 2; } int main(int a) { return f(a); }";
+    AnalyseError changedErr;
+    auto newfile = Analyser(Tokenize(changed)).Reanalyse(file, oldTokens, posrange_t(pos_t(0, 22), pos_t(0, 57)), changedErr);
+    CHECK(!changedErr);
+    CHECK(newfile != file);
+    CHECK(f->GetBlockStmt() == fblock);
+    CHECK(fblock->GetStmts()[0]->GetTokenIndex() == ret);
+    CHECK(file->ToString() == str);
+
+    // file is still good to reanalyse from oldTokens
+    std::string good = "int f(int n) { return n * 2; } int main() { return f(1); }";
+    AnalyseError goodErr;
+    Analyser(Tokenize(good)).Reanalyse(file, oldTokens, posrange_t(pos_t(0, 22), pos_t(0, 27)), goodErr);
+    CHECK(!goodErr);
+    CHECK(file->ToString() == Analyse(good, goodErr)->ToString());
+}
+
+TEST_CASE("parse without semantic analyse")
+{
+    std::string s = "int main() { x = f(1.5, \"s\"); return y; }";
+    const auto tokens = Tokenize(s);
+    AnalyseError err;
+    auto file = Analyser(tokens).Parse(err);
+    CHECK(!err);
+    REQUIRE(file != nullptr);
+    REQUIRE(file->GetFuncs().size() == 1);
+
+    // anchored to the identifier token
+    const auto assign = file->GetFuncs()[0]->GetBlockStmt()->GetStmts()[0];
+    CHECK(tokens[assign->GetTokenIndex()].GetString() == "x");
+
+    Analyser(tokens).Analyse(err);
+    CHECK(err);
+    CHECK(err.GetError() == "cannot find variable in assignment statement");
+    CHECK(err.GetToken().GetPosRange().first == pos_t(0, 13));
+
+    err = AnalyseError();
+    Analyse("int main() { const int c = 1; int x = 1; const int d = x; return 0; }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "expect const variable");
+
+    err = AnalyseError();
+    Analyse("void f() {} int main() { return f(); }", err);
+    CHECK(err);
+    CHECK(err.GetError() == "function has no return in function call expression");
+}
+
+TEST_CASE("semantic analyse inserts implicit cast")
+{
+    AnalyseError err;
+    auto file = Analyse("int main() { double d = 1; char c = 'a'; d = c + 1; if (d) return d; return 0; }", err);
+    REQUIRE(!err);
+    const auto block = file->GetFuncs()[0]->GetBlockStmt();
+    CHECK(block->GetVars()[0]->GetExpr()->GetASTType() == ASTType::CastExpr);
+    CHECK(block->GetStmts()[0]->ToString() == Analyse("int main() { double d; char c; d = c + 1; }", err)
+        ->GetFuncs()[0]->GetBlockStmt()->GetStmts()[0]->ToString());
+
+    const auto ifptr = dynamic_cast<IfStmtASTPtr>(block->GetStmts()[1]);
+    REQUIRE(ifptr != nullptr);
+    CHECK(ifptr->GetIfCond()->GetRightExpr()->GetVarType() == VarType::Float);
+}
+
+TEST_CASE("semantic analyse resolves expression types")
+{
+    std::string s = "int a = 1; double d; int f(int n) { return n; } int main() { int r; for (d = a; r; ) r = (d) + f(-a); return r; }";
+    AnalyseError err;
+    auto file = Analyser(Tokenize(s)).Parse(err);
+    REQUIRE(!err);
+    const auto forptr = static_cast<ForStmtASTPtr>(file->GetFuncs()[1]->GetBlockStmt()->GetStmts()[0]);
+    const auto init = forptr->GetInitExprs()[0];
+    const auto assign = static_cast<AssignStmtASTPtr>(forptr->GetBody());
+    const auto add = static_cast<BinaryExprASTPtr>(assign->GetExpr());
+    const auto brace = static_cast<BraceExprASTPtr>(add->GetLeftExpr());
+    const auto call = static_cast<FuncCallExprASTPtr>(add->GetRightExpr());
+    CHECK(call->GetDecl() == nullptr);
+
+    REQUIRE(SemaAnalyser(Tokenize(s)).Analyse(file, err));
+    CHECK(init->GetDecl() == file->GetVars()[1]);
+    CHECK(static_cast<IdentExprASTPtr>(brace->GetExpr())->GetDecl() == file->GetVars()[1]);
+    CHECK(call->GetDecl() == file->GetFuncs()[0]);
+    const auto neg = static_cast<UnaryExprASTPtr>(call->GetParams()[0]);
+    CHECK(static_cast<IdentExprASTPtr>(neg->GetExpr())->GetDecl() == file->GetVars()[0]);
+
+    // the cast inserted into the assignment keeps the type of its operand
+    CHECK(add->GetVarType() == VarType::Float);
+    CHECK(brace->GetVarType() == VarType::Float);
+    CHECK(neg->GetVarType() == VarType::Int);
+    CHECK(assign->GetExpr()->GetASTType() == ASTType::CastExpr);
+    CHECK(static_cast<CastExprASTPtr>(assign->GetExpr())->GetExpr() == add);
+
+    // statements are bound as well
+    file = Analyse("int a; void f() { int a; scan(a); } int main() { a = 1; f(); return a; }", err);
+    REQUIRE(!err);
+    const auto fblock = file->GetFuncs()[0]->GetBlockStmt();
+    const auto mblock = file->GetFuncs()[1]->GetBlockStmt();
+    CHECK(static_cast<ScanStmtASTPtr>(fblock->GetStmts()[0])->GetDecl() == fblock->GetVars()[0]);
+    CHECK(static_cast<AssignStmtASTPtr>(mblock->GetStmts()[0])->GetDecl() == file->GetVars()[0]);
+    CHECK(static_cast<FuncCallStmtASTPtr>(mblock->GetStmts()[1])->GetDecl() == file->GetFuncs()[0]);
+
+    // long chain of additions
+    std::string chain = "int main() { int a = 1, s; s = a";
+    for (int i = 0; i < 2000; ++i)
+        chain += " + a";
+    chain += "; return s; }";
+    file = Analyse(chain, err);
+    REQUIRE(!err);
+    CHECK(static_cast<AssignStmtASTPtr>(file->GetFuncs()[0]->GetBlockStmt()->GetStmts()[0])
+        ->GetExpr()->GetVarType() == VarType::Int);
+}
+
+TEST_CASE("symbol table")
+{
+    std::string s = "int a = 1; const int c = 2; int f(int a) { int b = a; { double a; a = b; } return a; } int main() { return f(c); }";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+    REQUIRE(!err);
+    const auto& symbols = file->GetSymbolTable();
+    const auto func = file->GetFuncs()[0];
+    const auto block = func->GetBlockStmt();
+    const auto inner = static_cast<BlockStmtASTPtr>(block->GetStmts()[0]);
+
+    // file, two functions and three blocks
+    CHECK(symbols.GetScopeCount() == 6);
+    const auto scope = symbols.GetScope(*file);
+    REQUIRE(scope != SymbolTable::NoScope);
+    CHECK(symbols.Find(scope, "f", false) == func);
+    CHECK(symbols.Find(scope, "a", false) == file->GetVars()[0]);
+    CHECK(symbols.Find(scope, "b", true) == nullptr);
+    CHECK(symbols.Find(symbols.GetScope(*block), "b", false) == block->GetVars()[0]);
+
+    // innermost declaration shadows the outer ones
+    CHECK(inner->GetSymbol("a", false) == inner->GetVars()[0]);
+    CHECK(block->GetSymbol("a", true) == func->GetParams()[0]);
+    CHECK(block->GetSymbol("a", false) == nullptr);
+    CHECK(file->GetSymbol("a", true) == file->GetVars()[0]);
+    CHECK(inner->GetSymbolType("c", true) == SymbolType::ConstVar);
+    CHECK(inner->GetSymbolType("main", true) == SymbolType::Func);
+    CHECK(inner->GetSymbolType("a", true) == SymbolType::Var);
+    CHECK(inner->GetSymbol("x", true) == nullptr);
+
+    // the scope owner keeps the table, the lookup never climbs to the file
+    inner->SetParent(nullptr);
+    CHECK(inner->GetSymbol("b", true) == block->GetVars()[0]);
+    CHECK(inner->GetSymbol("f", true) == func);
+    inner->SetParent(block);
+
+    std::string deep = "int x; int main() { ";
+    for (int i = 0; i < 500; ++i)
+        deep += "{ ";
+    deep += "x = 1; ";
+    for (int i = 0; i < 500; ++i)
+        deep += "} ";
+    deep += "return x; }";
+    auto deepFile = Analyse(deep, err);
+    REQUIRE(!err);
+    auto innermost = deepFile->GetFuncs()[0]->GetBlockStmt();
+    while (!innermost->GetStmts().empty() && innermost->GetStmts()[0]->GetASTType() == ASTType::BlockStmt)
+        innermost = static_cast<BlockStmtASTPtr>(innermost->GetStmts()[0]);
+    CHECK(innermost->GetSymbol("x", true) == deepFile->GetVars()[0]);
+
+    // a tree not analysed has no table and scans its nodes
+    auto parsed = Analyser(Tokenize(s)).Parse(err);
+    REQUIRE(!err);
+    CHECK(parsed->GetSymbolTable().GetScopeCount() == 0);
+    const auto pfunc = parsed->GetFuncs()[0];
+    CHECK(pfunc->GetBlockStmt()->GetSymbol("a", true) == pfunc->GetParams()[0]);
+    CHECK(pfunc->GetBlockStmt()->GetSymbolType("c", true) == SymbolType::ConstVar);
+
+    // scopes of released function bodies are dropped with their nodes
+    file = Analyser(Tokenize(s)).Analyse([](const DeclASTPtr&) { return true; }, true, err);
+    REQUIRE(!err);
+    CHECK(file->GetSymbolTable().GetScopeCount() == 1);
+    CHECK(file->GetSymbol("c", false) == file->GetVars()[1]);
+
+    // a failed analyse leaves no table behind
+    file = Analyse("int a; int main() { int b; int b; }", err);
+    CHECK(err.GetError() == "variable name repeated");
+    CHECK(file->GetSymbolTable().GetScopeCount() == 0);
+    CHECK(file->GetFuncs()[0]->GetBlockStmt()->GetSymbol("b", false) == file->GetFuncs()[0]->GetBlockStmt()->GetVars()[0]);
+}
+
+TEST_CASE("xref index")
+{
+    std::string s = "int a = 1;\nint f(int n) { int a; scan(a); return n + a; }\nint main() { a = f(a); f(2); return a; }";
+    const auto tokens = Tokenize(s);
+    AnalyseError err;
+    auto file = Analyser(tokens).Analyse(err);
+    REQUIRE(!err);
+
+    XRefIndex xref(*file, tokens);
+    // a, f, n, local a, main
+    REQUIRE(xref.GetDeclCount() == 5);
+    const auto global = xref.FindDecl(pos_t(0, 4));
+    REQUIRE(global != XRefIndex::NoDecl);
+    CHECK(xref.GetDecl(global).name == "a");
+    CHECK(xref.GetDecl(global).type == DeclType::Var);
+    REQUIRE(xref.GetUseCount(global) == 3);
+    CHECK(xref.GetUse(global, 0) == posrange_t(pos_t(2, 13), pos_t(2, 14)));
+    CHECK(xref.GetUse(global, 1) == posrange_t(pos_t(2, 19), pos_t(2, 20)));
+    CHECK(xref.GetUse(global, 2) == posrange_t(pos_t(2, 36), pos_t(2, 37)));
+
+    // uses go back to their own declaration
+    const auto local = xref.FindDecl(pos_t(1, 19));
+    CHECK(local != global);
+    CHECK(xref.FindDecl(pos_t(1, 42)) == local);
+    CHECK(xref.GetUseCount(local) == 2);
+    const auto func = xref.FindDecl(pos_t(2, 23));
+    CHECK(xref.GetDecl(func).name == "f");
+    CHECK(xref.GetDecl(func).type == DeclType::Func);
+    CHECK(xref.GetUseCount(func) == 2);
+    CHECK(xref.FindDecl(pos_t(1, 4)) == func);
+    CHECK(xref.FindDecl(pos_t(1, 5)) == XRefIndex::NoDecl);
+    CHECK(xref.FindDecl(pos_t(0, 0)) == XRefIndex::NoDecl);
+    CHECK(xref.FindDecl(pos_t(0, 5)) == XRefIndex::NoDecl);
+
+    // saved and loaded the index answers the same
+    std::stringstream ss;
+    xref.Save(ss);
+    XRefIndex loaded;
+    REQUIRE(loaded.Load(ss));
+    REQUIRE(loaded.GetDeclCount() == xref.GetDeclCount());
+    for (std::size_t i = 0; i < xref.GetDeclCount(); ++i)
+    {
+        CHECK(loaded.GetDecl(i).name == xref.GetDecl(i).name);
+        CHECK(loaded.GetDecl(i).range == xref.GetDecl(i).range);
+        REQUIRE(loaded.GetUseCount(i) == xref.GetUseCount(i));
+        for (std::size_t j = 0; j < xref.GetUseCount(i); ++j)
+            CHECK(loaded.GetUse(i, j) == xref.GetUse(i, j));
+    }
+    CHECK(loaded.FindDecl(pos_t(1, 42)) == local);
+
+    // truncated stream is rejected
+    const auto data = ss.str();
+    std::istringstream truncated(data.substr(0, data.size() - 1));
+    CHECK(!loaded.Load(truncated));
+    CHECK(loaded.GetDeclCount() == 0);
+}
+
+TEST_CASE("call graph")
+{
+    std::string s = R"(
+int a(int n) { if (n) return b(n - 1); return 0; }
+int b(int n) { return a(n); }
+void c() { c(); }
+void d() { print(a(1), a(2)); }
+int main() { d(); return 0; }
+)";
+    AnalyseError err;
+    auto tokens = Tokenize(s);
+    auto file = Analyser(tokens).Analyse(err);
+    REQUIRE(!err);
+
+    CallGraph graph(*file);
+    REQUIRE(graph.GetFuncCount() == 5);
+    CHECK(graph.GetName(4) == "main");
+    REQUIRE(graph.GetCalleeCount(3) == 1);
+    CHECK(graph.GetCallee(3, 0) == 0);
+    CHECK(graph.IsCalling(4, 3));
+    CHECK(!graph.IsCalling(4, 0));
+    REQUIRE(graph.GetCallerCount(0) == 2);
+    CHECK(graph.GetCaller(0, 0) == 1);
+    CHECK(graph.GetCaller(0, 1) == 3);
+    CHECK(graph.GetCallerCount(4) == 0);
+
+    // a and b call each other, c calls itself
+    CHECK(graph.GetSCCCount() == 4);
+    CHECK(graph.GetSCC(0) == graph.GetSCC(1));
+    CHECK(graph.GetSCCSize(graph.GetSCC(0)) == 2);
+    CHECK(graph.IsRecursive(0));
+    CHECK(graph.IsRecursive(2));
+    CHECK(!graph.IsRecursive(3));
+    CHECK(!graph.IsRecursive(4));
+    // callees first
+    CHECK(graph.GetSCC(0) < graph.GetSCC(3));
+    CHECK(graph.GetSCC(3) < graph.GetSCC(4));
+
+    // long call chain
+    std::string chain;
+    const std::size_t N = 20000;
+    for (std::size_t i = 0; i < N; ++i)
+        chain += "void f" + std::to_string(i) + "() { f" + std::to_string((i + 1) % N) + "(); }\n";
+    auto chainFile = Analyser(Tokenize(chain)).Parse(err);
+    REQUIRE(!err);
+    CallGraph chainGraph(*chainFile);
+    CHECK(chainGraph.GetSCCCount() == 1);
+    CHECK(chainGraph.IsRecursive(N / 2));
+
+    // same tokens get the same graph
+    CallGraphCache cache;
+    const auto cached = cache.Get(*file, tokens);
+    CHECK(cached->GetFuncCount() == 5);
+    std::string spaced = s;
+    spaced.insert(0, "\n\n");
+    auto spacedTokens = Tokenize(spaced);
+    auto spacedFile = Analyser(spacedTokens).Analyse(err);
+    REQUIRE(!err);
+    CHECK(cache.Get(*spacedFile, spacedTokens) == cached);
+    CHECK(cache.GetSize() == 1);
+
+    std::string changed = s + "void e() { c(); }";
+    auto changedTokens = Tokenize(changed);
+    auto changedFile = Analyser(changedTokens).Analyse(err);
+    REQUIRE(!err);
+    const auto other = cache.Get(*changedFile, changedTokens);
+    CHECK(other != cached);
+    CHECK(other->GetCallerCount(2) == 2);
+    CHECK(cache.GetSize() == 2);
+    cache.Clear();
+    CHECK(cache.GetSize() == 0);
+
+    // the least recently used graph is dropped past the capacity
+    CallGraphCache small(2);
+    const auto first = small.Get(*file, tokens);
+    small.Get(*changedFile, changedTokens);
+    CHECK(small.Get(*spacedFile, spacedTokens) == first);
+    std::string third = s + "void f() { }";
+    auto thirdTokens = Tokenize(third);
+    auto thirdFile = Analyser(thirdTokens).Analyse(err);
+    REQUIRE(!err);
+    small.Get(*thirdFile, thirdTokens);
+    CHECK(small.GetSize() == 2);
+    CHECK(small.Get(*file, tokens) == first);
+    CHECK(small.Get(*changedFile, changedTokens) != other);
+    CHECK_THROWS_AS(CallGraphCache(0), std::logic_error);
+}
+
+TEST_CASE("const evaluator")
+{
+    std::string s = R"(
+const int a = 2 * (3 + 4), b = -a / 3;
+const char c = 'a';
+const double d = a / 4.0;
+const int z = 1 / 0;
+int g = a;
+const double inf = 1.0 / 0.0;
+int main() { const int e = b + c; int x; x = e * 2; if (a > b) x = 0; return (int)d + x; }
+)";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+    REQUIRE(!err);
+    const auto& vars = file->GetVars();
+    ConstEvaluator consts(*file);
+
+    ConstValue value;
+    REQUIRE(consts.Evaluate(*vars[0]->GetExpr(), value));
+    CHECK(value.type == VarType::Int);
+    CHECK(value.GetInt() == 14);
+    REQUIRE(consts.Evaluate(*vars[1]->GetExpr(), value));
+    CHECK(value.GetInt() == -4);
+    REQUIRE(consts.Evaluate(*vars[3]->GetExpr(), value));
+    CHECK(value.type == VarType::Float);
+    CHECK(value.GetFloat() == 3.5);
+    CHECK(!consts.IsConst(*vars[4]->GetExpr()));
+    REQUIRE(consts.Evaluate(*vars[5]->GetExpr(), value));
+    CHECK(value.GetInt() == 14);
+    CHECK(!consts.IsConst(*vars[6]->GetExpr()));
+
+    const auto block = file->GetFuncs()[0]->GetBlockStmt();
+    REQUIRE(consts.Evaluate(*block->GetVars()[0]->GetExpr(), value));
+    CHECK(value.GetInt() == 'a' - 4);
+    const auto assign = static_cast<AssignStmtASTPtr>(block->GetStmts()[0]);
+    REQUIRE(consts.Evaluate(*assign->GetExpr(), value));
+    CHECK(value.GetInt() == ('a' - 4) * 2);
+    CHECK(!consts.IsConst(*static_cast<IfStmtASTPtr>(block->GetStmts()[1])->GetIfCond()));
+    CHECK(!consts.IsConst(*static_cast<ReturnStmtASTPtr>(block->GetStmts()[2])->GetExpr()));
+
+    // folding gives a literal and leaves the tree as it was
+    const auto folded = consts.Fold(file->GetContext(), assign->GetExpr());
+    REQUIRE(folded->GetASTType() == ASTType::IntExpr);
+    CHECK(folded->GetInt() == ('a' - 4) * 2);
+    CHECK(folded->GetParent() == assign);
+    CHECK(assign->GetExpr()->GetASTType() == ASTType::BinaryExpr);
+    CHECK(consts.IsConst(*folded));
+
+    // long chain of const globals
+    std::string chain = "const int c0 = 0;";
+    const int N = 20000;
+    for (int i = 1; i < N; ++i)
+        chain += "const int c" + std::to_string(i) + " = c" + std::to_string(i - 1) + " + 1;";
+    chain += "int main() { return c" + std::to_string(N - 1) + "; }";
+    file = Analyse(chain, err);
+    REQUIRE(!err);
+    ConstEvaluator chainConsts(*file);
+    const auto ret = static_cast<ReturnStmtASTPtr>(file->GetFuncs()[0]->GetBlockStmt()->GetStmts()[0]);
+    REQUIRE(chainConsts.Evaluate(*ret->GetExpr(), value));
+    CHECK(value.GetInt() == N - 1);
+
+    // const only makes a variable read-only, analyse takes one of no constant value
+    file = Analyse("int f(const int p) { const int q = p + 1; return q; } int main() { return f(1); }", err);
+    REQUIRE(!err);
+    ConstEvaluator paramConsts(*file);
+    const auto q = file->GetFuncs()[0]->GetBlockStmt()->GetVars()[0];
+    CHECK(!paramConsts.IsConst(*q->GetExpr()));
+}
+
+TEST_CASE("control flow graph")
+{
+    std::string s = R"(
+int f(int p) {
+    int a;
+    if (p > 0) a = 1; else a = 2;
+    while (p > 0) { if (p > 5) break; p = p - 1; }
+    return a;
+    print(a);
+}
+)";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+    REQUIRE(!err);
+    const auto& func = *file->GetFuncs()[0];
+    CFG cfg(func);
+
+    const auto blockOf = [&cfg](const AST* ast)
+    {
+        for (std::size_t block = 0; block < cfg.GetBlockCount(); ++block)
+        {
+            for (std::size_t i = 0; i < cfg.GetElementCount(block); ++i)
+            {
+                if (&cfg.GetElement(block, i) == ast)
+                    return block;
+            }
+        }
+        return CFG::NoBlock;
+    };
+    const auto& stmts = func.GetBlockStmt()->GetStmts();
+    const auto ifStmt = static_cast<IfStmtASTPtr>(stmts[0]);
+    const auto whileStmt = static_cast<WhileStmtASTPtr>(stmts[1]);
+    const auto body = static_cast<BlockStmtASTPtr>(whileStmt->GetStmt());
+    const auto breakStmt = static_cast<IfStmtASTPtr>(body->GetStmts()[0])->GetIFStmt();
+
+    REQUIRE(blockOf(ifStmt->GetIfCond()) == CFG::Entry);
+    CHECK(cfg.GetElementCount(CFG::Entry) == 2);
+    const auto thenBlock = blockOf(ifStmt->GetIFStmt());
+    const auto elseBlock = blockOf(ifStmt->GetElseStmt());
+    const auto cond = blockOf(whileStmt->GetCond());
+    const auto breakBlock = blockOf(breakStmt);
+    const auto ret = blockOf(stmts[2]);
+    const auto dead = blockOf(stmts[3]);
+    REQUIRE(cfg.GetSuccCount(CFG::Entry) == 2);
+    CHECK(cfg.GetSucc(CFG::Entry, 0) == thenBlock);
+    CHECK(cfg.GetSucc(CFG::Entry, 1) == elseBlock);
+
+    CHECK(cfg.GetRPONumber(CFG::Entry) == 0);
+    CHECK(cfg.IsReachable(ret));
+    CHECK(!cfg.IsReachable(dead));
+    CHECK(cfg.GetIDom(dead) == CFG::NoBlock);
+    CHECK(cfg.GetIDom(CFG::Entry) == CFG::Entry);
+    CHECK(cfg.GetIDom(thenBlock) == CFG::Entry);
+    CHECK(cfg.GetIDom(cfg.GetIDom(cond)) == CFG::Entry);
+    CHECK(cfg.GetIDom(CFG::Exit) == ret);
+    CHECK(cfg.Dominates(CFG::Entry, CFG::Exit));
+    CHECK(cfg.Dominates(cond, cond));
+    CHECK(!cfg.Dominates(thenBlock, cond));
+    CHECK(cfg.Dominates(cond, breakBlock));
+    CHECK(cfg.Dominates(cond, ret));
+    CHECK(!cfg.Dominates(breakBlock, ret));
+    CHECK(!cfg.Dominates(CFG::Entry, dead));
+
+    // a block comes before its successors in rpo but along a back edge, whose target dominates its source
+    std::size_t children = 0;
+    for (std::size_t i = 0; i < cfg.GetRPOCount(); ++i)
+    {
+        const auto block = cfg.GetRPOBlock(i);
+        CHECK(cfg.GetRPONumber(block) == i);
+        children += cfg.GetDomChildCount(block);
+        for (std::size_t j = 0; j < cfg.GetSuccCount(block); ++j)
+        {
+            const auto succ = cfg.GetSucc(block, j);
+            CHECK((cfg.GetRPONumber(succ) > i || cfg.Dominates(succ, block)));
+        }
+    }
+    CHECK(children == cfg.GetRPOCount() - 1);
+
+    // long and deeply nested bodies
+    std::string big = "int main() { int p; scan(p);";
+    const int N = 20000;
+    for (int i = 0; i < N; ++i)
+        big += " if (p > " + std::to_string(i) + ") p = p - 1;";
+    const int M = 100;
+    for (int i = 0; i < M; ++i)
+        big += " while (p > 0) {";
+    big += " p = p - 1;" + std::string(M, '}') + " return p; }";
+    file = Analyse(big, err);
+    REQUIRE(!err);
+    CFG bigCfg(*file->GetFuncs()[0]);
+    // only the block after return is dead
+    CHECK(bigCfg.GetRPOCount() == bigCfg.GetBlockCount() - 1);
+    CHECK(bigCfg.Dominates(CFG::Entry, CFG::Exit));
+    // Exit, the block of return, the outer loop condition, then the join of each if
+    std::size_t depth = 0;
+    for (auto block = CFG::Exit; block != CFG::Entry; block = bigCfg.GetIDom(block))
+        ++depth;
+    CHECK(depth == N + 3);
+}
+
+TEST_CASE("definite assignment")
+{
+    std::string s = R"(
+int g;
+int f(int p) {
+    int a, b, c, d, e, i;
+    int h = 1;
+    if (p > 0) { a = 1; b = 1; } else { a = 2; }
+    print(a);
+    print(b);
+    while (p > 0) { c = 1; p = p - 1; }
+    print(c);
+    do { d = 1; } while (p > 0);
+    print(d);
+    scan(e);
+    for (i = 0; i < 3; i = i + 1) { int t; if (i > 1) t = 1; print(t); }
+    switch (p) {
+    case 0: a = 1;
+    case 1: { print(e, g, p, h, i); break; }
+    default: return f(b);
+    }
+    return 0;
+    print(b, c);
+}
+)";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+    REQUIRE(!err);
+    const auto& func = *file->GetFuncs()[0];
+    CFG cfg(func);
+    CHECK(cfg.GetPredCount(CFG::Entry) == 0);
+    CHECK(cfg.GetSuccCount(CFG::Exit) == 0);
+
+    DefiniteAssignment da(func, cfg);
+    REQUIRE(da.GetVarCount() == 8);
+    CHECK(da.GetVar(0).GetName() == "a");
+    CHECK(da.GetVar(7).GetName() == "t");
+    CHECK(da.GetVarIndex(*func.GetParams()[0]) == DefiniteAssignment::NoVar);
+
+    // b in one branch, c in a loop that may not run, t declared again each iteration, reads after return left out
+    std::vector<std::string> names;
+    for (const auto read : da.GetUninitReads())
+        names.push_back(read->GetName());
+    CHECK(names == std::vector<std::string>{ "b", "c", "t", "b" });
+
+    const auto& exit = da.GetAssignedIn(CFG::Exit);
+    CHECK(exit.Test(da.GetVarIndex(da.GetVar(0))));
+    CHECK(!exit.Test(1));
+    CHECK(!exit.Test(2));
+    CHECK(exit.Test(3));
+    CHECK(exit.Test(4));
+    CHECK(exit.Test(5));
+    CHECK(exit.Test(6));
+
+    // long function, each variable assigned on both branches of an if
+    std::string big = "int main() { int p;";
+    const int N = 3000;
+    for (int i = 0; i < N; ++i)
+        big += " int v" + std::to_string(i) + ";";
+    big += " int w; scan(p);";
+    for (int i = 0; i < N; ++i)
+    {
+        const auto v = "v" + std::to_string(i);
+        big += " if (p > " + std::to_string(i) + ") " + v + " = p; else " + v + " = 0; print(" + v + ");";
+    }
+    big += " print(w); return 0; }";
+    file = Analyse(big, err);
+    REQUIRE(!err);
+    const auto& main = *file->GetFuncs()[0];
+    CFG bigCfg(main);
+    DefiniteAssignment bigDa(main, bigCfg);
+    CHECK(bigDa.GetVarCount() == N + 2);
+    REQUIRE(bigDa.GetUninitReads().size() == 1);
+    CHECK(bigDa.GetUninitReads()[0]->GetName() == "w");
+}
+
+TEST_CASE("function flow")
+{
+    std::string s = R"(
+int f(int p) { if (p > 0) return 1; else return 0; }
+int g(int p) { while (1) { if (p > 0) return p; p = p + 1; } }
+void h() { }
+int main() {
+    int a, i;
+    for (i = 0; i < 3; i = i + 1) { continue; print(i); }
+    while (i > 0) { break; i = 0; if (i > 1) print(i); }
+    if (i > 0) a = 1;
+    print(a);
+    return 0;
+    print(a);
+    i = 2;
+}
+)";
+    Analyser ayer(Tokenize(s));
+    AnalyseError err;
+    auto file = ayer.Analyse(err);
+    REQUIRE(!err);
+
+    // one warning for each piece of dead code
+    std::vector<std::pair<std::string, pos_t>> warnings;
+    for (const auto& warning : ayer.GetWarnings())
+    {
+        CHECK(warning.IsWarning());
+        warnings.emplace_back(warning.GetError(), warning.GetToken().GetPosRange().first);
+    }
+    REQUIRE(warnings.size() == 4);
+    CHECK(warnings[0].first == "unreachable code");
+    CHECK(warnings[0].second == pos_t(6, 46));
+    CHECK(warnings[1].first == "unreachable code");
+    CHECK(warnings[1].second == pos_t(7, 27));
+    CHECK(warnings[2].first == "unreachable code");
+    CHECK(warnings[2].second == pos_t(11, 4));
+    CHECK(warnings[3].first == "variable 'a' may be used before assigned");
+    CHECK(warnings[3].second == pos_t(9, 10));
+    CHECK(std::to_string(ayer.GetWarnings()[0]).find("warning: unreachable code") == 0);
+
+    // a path to the end of a non-void function
+    const char* missing[] = {
+        "int f(int p) { if (p > 0) return 1; }",
+        "int f(int p) { while (p > 0) return 1; }",
+        "int f(int p) { switch (p) { case 0: return 1; } }",
+        "int f(int p) { while (1) { if (p > 0) break; return 1; } }",
+        "int f(int p) { }",
+    };
+    for (const auto src : missing)
+    {
+        Analyser missingAyer(Tokenize(src));
+        AnalyseError missingErr;
+        missingAyer.Analyse(missingErr);
+        CHECK(!missingErr);
+        REQUIRE(missingAyer.GetWarnings().size() == 1);
+        CHECK(missingAyer.GetWarnings()[0].GetError() == "missing return at the end of non-void function");
+        CHECK(missingAyer.GetWarnings()[0].IsWarning());
+    }
+
+    const char* returning[] = {
+        "int f(int p) { switch (p) { case 0: return 1; default: return 0; } }",
+        "int f(int p) { do { if (p > 0) return p; p = p + 1; } while (1); }",
+        "int f(int p) { for (p = 0; 1; ) p = p + 1; }",
+        "int f(int p) { { return 1; } }",
+        "int f(int n) { int i; for (i = 0; i < n; i = i + 1) { return i; } return n; }",
+        "int f(int p) { do { return 1; } while (0); }",
+    };
+    for (const auto src : returning)
+    {
+        Analyser returningAyer(Tokenize(src));
+        AnalyseError returningErr;
+        returningAyer.Analyse(returningErr);
+        CHECK(!returningErr);
+        CHECK(returningAyer.GetWarnings().empty());
+    }
+
+    // a loop written after return is still dead code, warned at its body
+    Analyser deadLoopAyer(Tokenize("int f(int p) { return 1; while (p > 0) p = 0; }"));
+    AnalyseError deadLoopErr;
+    deadLoopAyer.Analyse(deadLoopErr);
+    REQUIRE(!deadLoopErr);
+    REQUIRE(deadLoopAyer.GetWarnings().size() == 1);
+    CHECK(deadLoopAyer.GetWarnings()[0].GetToken().GetPosRange().first == pos_t(0, 39));
+}
+
+TEST_CASE("type checker")
+{
+    std::string s = R"(
+void v() { }
+int f(int a) { return a; }
+void g() { return 1; }
+int main() {
+    int i;
+    double d = 1;
+    i = "s";
+    i = v();
+    d = -"x" + 1;
+    switch ("s") { case 1: i = 1; }
+    i = f(1, 2);
+    i = f(d) + (int)'c';
+    return d;
+}
+)";
+    const auto tokens = Tokenize(s);
+    Analyser ayer(tokens);
+    AnalyseError err;
+    auto file = ayer.Parse(err);
+    REQUIRE(!err);
+
+    // every error of the file, one for each mistake
+    AnalyseErrorList errs;
+    CHECK(!TypeChecker(tokens).Check(file, errs));
+    std::vector<std::string> msgs;
+    for (const auto& e : errs)
+        msgs.push_back(e.GetError());
+    CHECK(msgs == std::vector<std::string>{
+        "void function cannot return any value",
+        "invalid assignment statement, cannot inexplicit cast type from 'string' to 'int'",
+        "function has no return in function call expression",
+        "cannot apply unary operator on string",
+        "invalid switch condition expression type:string",
+        "parameter number mismatch in function call expression, need 1, have 2",
+    });
+    CHECK(errs[1].GetToken().GetPosRange().first == pos_t(7, 6));
+
+    // semantic analyse reports the first error of the checker
+    AnalyseError semaErr;
+    Analyse(s, semaErr);
+    CHECK(semaErr.GetError() == errs[0].GetError());
+    CHECK(semaErr.GetToken().GetPosRange().first == errs[0].GetToken().GetPosRange().first);
+
+    // names of a declaration are bound before its types are checked
+    semaErr = AnalyseError();
+    Analyse("int main() { int i; i = \"s\"; j = 1; return 0; }", semaErr);
+    CHECK(semaErr.GetError() == "cannot find variable in assignment statement");
+    semaErr = AnalyseError();
+    Analyse("int main() { const int c = 1; c = \"s\"; return 0; }", semaErr);
+    CHECK(semaErr.GetError() == "cannot assign on const variable in assignment statement");
+
+    // casts inserted as semantic analyse does
+    const auto& stmts = file->GetFuncs()[3]->GetBlockStmt()->GetStmts();
+    CHECK(stmts[5]->ToString() == Analyse("int f(int a) { return a; } int main() { int i; double d; i = f(d) + (int)'c'; return 0; }", err)
+        ->GetFuncs()[1]->GetBlockStmt()->GetStmts()[0]->ToString());
+    CHECK(static_cast<ReturnStmtASTPtr>(stmts[6])->GetExpr()->GetASTType() == ASTType::CastExpr);
+
+    // a parsed tree checked equals the analysed one, which is checked already and left as it is
+    std::string rich = R"(
+const char C = 'x';
+double d = 1.5, e;
+void show(int a, double b) { print(a, b); }
+int main() {
+    int i;
+    char c = 'a';
+    for (i = 0; i < 10; i = i + 1, show(i, d)) {
+        switch (c) { case 'a': c = c + 1; default: c = 'z'; }
+        if (d) e = (int)d / 2;
+    }
+    show(-i, -d);
+    return (int)(e + C);
+}
+)";
+    const auto richTokens = Tokenize(rich);
+    Analyser richAyer(richTokens);
+    auto parsed = richAyer.Parse(err);
+    REQUIRE(!err);
+    errs.clear();
+    REQUIRE(TypeChecker(richTokens).Check(parsed, errs));
+    auto analysed = Analyse(rich, err);
+    REQUIRE(!err);
+    CHECK(parsed->ToString() == analysed->ToString());
+
+    const auto nodeCount = analysed->GetContext().GetNodeCount();
+    const auto text = analysed->ToString();
+    REQUIRE(TypeChecker(richTokens).Check(analysed, errs));
+    CHECK(errs.empty());
+    CHECK(analysed->GetContext().GetNodeCount() == nodeCount);
+    CHECK(analysed->ToString() == text);
+}
+
+TEST_CASE("incremental reanalyse token index")
+{
+    std::string olds = "int a = 1; int f() { return a; } int main() { return f(); }";
+    std::string news = "int a = 1 + 2; int f() { return a + 1; } int main() { return f(); }";
+    const auto oldTokens = Tokenize(olds);
+    AnalyseError err;
+    auto file = Analyser(oldTokens).Analyse(err);
+    REQUIRE(!err);
+
+    const posrange_t edit(pos_t(0, 8), pos_t(0, 38));
+    Analyser(Tokenize(news)).Reanalyse(file, oldTokens, edit, err);
+    REQUIRE(!err);
+
+    TokenIndexCollector reanalysed;
+    file->Accept(reanalysed);
+    TokenIndexCollector analysed;
+    Analyse(news, err)->Accept(analysed);
+    CHECK(reanalysed.indexes == analysed.indexes);
+}
+
+TEST_CASE("streaming analyse")
+{
+    std::string s = R"(
+int a = 1, b = a;
+
+int main()
+{
+    return f(b);
+}
+
+int f(int n)
+{
+    return n + a;
+}
+)";
+    std::vector<str_t> names;
+    auto callback = [&](const DeclASTPtr& decl)
+    {
+        if (decl->GetASTType() == ASTType::FuncDecl)
+        {
+            auto func = static_cast<FuncDeclASTPtr>(decl);
+            CHECK(func->GetBlockStmt() != nullptr);
+            names.push_back(func->GetName());
+        }
+        else
+        {
+            names.push_back(static_cast<VarDeclASTPtr>(decl)->GetName());
+        }
+        return true;
+    };
+
+    AnalyseError err;
+    auto file = Analyser(Tokenize(s)).Analyse(callback, true, err);
+    CHECK(!err);
+    CHECK(names == std::vector<str_t>{ "a", "b", "main", "f" });
+    REQUIRE(file->GetFuncs().size() == 2);
+    for (const auto& func : file->GetFuncs())
+        CHECK(func->GetBlockStmt() == nullptr);
+    CHECK(!file->GetVars()[0]->HasExpr());
+
+    // stop at the first declaration
+    names.clear();
+    file = Analyser(Tokenize(s)).Analyse([&](const DeclASTPtr& decl)
+    {
+        return callback(decl) && false;
+    }, false, err);
+    CHECK(!err);
+    CHECK(names.size() == 1);
+    CHECK(file->GetVars()[0]->HasExpr());
+
+    // semantic error stops before callback
+    names.clear();
+    Analyser(Tokenize("int a = 1; int main() { return g; } int f() { return 0; }")).Analyse(callback, true, err);
+    CHECK(err);
+    CHECK(err.GetError() == "unknown identifier in primary expression");
+    CHECK(names == std::vector<str_t>{ "a" });
+}
+
+#ifndef C0_NO_AST_INSTANCE_COUNT
+TEST_CASE("ast context")
+{
+    const auto count = AST::GetInstanceCount();
+    {
+        ASTContext context;
+        auto left = context.New<IntExprAST>(nullptr, 1);
+        const auto mark = context.GetMark();
+        auto right = context.New<IntExprAST>(nullptr, 2);
+        context.New<BinaryExprAST>(nullptr, left, BinaryType::Add, right);
+        CHECK(context.GetNodeCount() == 3);
+        CHECK(AST::GetInstanceCount() == count + 3);
+
+        context.Rewind(mark);
+        CHECK(context.GetNodeCount() == 1);
+        CHECK(AST::GetInstanceCount() == count + 1);
+        CHECK(context.New<IntExprAST>(nullptr, 3) == right);
+    }
+    CHECK(AST::GetInstanceCount() == count);
+
+    std::string s = "int a = 1; int f(int n) { return n * a; } int main() { print(f(2)); return 0; }";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+    REQUIRE(!err);
+    const auto nodes = file->GetContext().GetNodeCount();
+    CHECK(AST::GetInstanceCount() == count + nodes + 1);
+    file = nullptr;
+    CHECK(AST::GetInstanceCount() == count);
+
+    // released function bodies are destroyed
+    file = Analyser(Tokenize(s)).Analyse([](const DeclASTPtr&) { return true; }, true, err);
+    REQUIRE(!err);
+    CHECK(file->GetContext().GetNodeCount() < nodes);
+    CHECK(AST::GetInstanceCount() == count + file->GetContext().GetNodeCount() + 1);
+}
+
+TEST_CASE("ast instance count across threads")
+{
+    const auto count = AST::GetInstanceCount();
+    const auto files = AST::GetInstanceMap()[ASTType::File];
+    std::string s = "int a = 1; int f(int n) { return n * a; } int main() { print(f(2)); return 0; }";
+
+    std::vector<FileASTPtr> results(4);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            AnalyseError err;
+            results[i] = Analyse(s, err);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    std::int32_t nodes = 0;
+    for (const auto& file : results)
+    {
+        REQUIRE(file != nullptr);
+        nodes += static_cast<std::int32_t>(file->GetContext().GetNodeCount()) + 1;
+    }
+    CHECK(AST::GetInstanceCount() == count + nodes);
+    CHECK(AST::GetInstanceMap()[ASTType::File] == files + 4);
+
+    // destroyed by another thread than created
+    results.clear();
+    CHECK(AST::GetInstanceCount() == count);
+}
+#endif
+
+TEST_CASE("static ast visitor")
+{
+    std::string s = R"(
+int g = 2;
+
+int f(int n)
+{
+    switch (n + 1)
+    {
+    case 1:
+        return 1;
+    default:
+        g = 0;
+    }
+    if (n) print(n); else scan(g);
+    return f(n - 1) * 3;
+}
+
+int main()
+{
+    int i;
+    for (i = 0; i < 4; i = i + 1)
+        do g = g - 1; while (g > 5);
+    return f(-4);
+}
+)";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+    REQUIRE(!err);
+
+    IntExprCounter counter;
+    file->Accept(counter);
+    StaticIntExprCounter staticCounter;
+    staticCounter.Visit(*file);
+    // switch expression is not visited by Accept
+    CHECK(counter.count == 12);
+    CHECK(staticCounter.count == 13);
+
+    const FlatAST flat(*file);
+    StaticNodeCounter nodes;
+    nodes.Visit(*file);
+    CHECK(nodes.count == flat.GetNodes().size());
+
+    std::size_t ints = 0;
+    for (const auto& node : flat.GetNodes())
+        if (node.GetASTType() == ASTType::IntExpr)
+            ++ints;
+    CHECK(staticCounter.count == ints);
+
+    // the dump is the same by the virtual interface and by static dispatch
+    std::ostringstream accepted;
+    DumpVisitor acceptDumper(accepted);
+    file->Accept(acceptDumper);
+    std::ostringstream visited;
+    DumpVisitor visitDumper(visited);
+    visitDumper.Visit(*file);
+    CHECK(accepted.str() == visited.str());
+    CHECK(accepted.str().find("    switch (n + 1)") != std::string::npos);
+}
+
+TEST_CASE("ast node id and user data")
+{
+    // vtable pointer and 16 bytes header
+    CHECK(sizeof(AST) == sizeof(void*) + 16);
+
+    struct Tag : public ASTUserData
+    {
+        Tag(int v) : value(v) {}
+        int value;
+    };
+
+    ASTContext context;
+    auto a = context.New<IntExprAST>(nullptr, 1);
+    const auto mark = context.GetMark();
+    auto b = context.New<IntExprAST>(nullptr, 2);
+    CHECK(a->GetId() == 1);
+    CHECK(b->GetId() == 2);
+    CHECK(context.GetNode(2) == b);
+    CHECK(a->GetASTType() == ASTType::IntExpr);
+
+    context.SetUserData(*a, std::make_shared<Tag>(10));
+    context.SetUserData(*b, std::make_shared<Tag>(20));
+    CHECK(std::static_pointer_cast<Tag>(context.GetUserData(*a))->value == 10);
+    CHECK(std::static_pointer_cast<Tag>(context.GetUserData(*b))->value == 20);
+
+    // user data of rewound nodes is dropped with them
+    context.Rewind(mark);
+    auto c = context.New<IntExprAST>(nullptr, 3);
+    CHECK(c->GetId() == 2);
+    CHECK(context.GetUserData(*c) == nullptr);
+    CHECK(context.GetUserData(*a) != nullptr);
+    context.SetUserData(*a, nullptr);
+    CHECK(context.GetUserData(*a) == nullptr);
+}
+
+TEST_CASE("ast attribute")
+{
+    std::string s = "int g = 2 + 3 * 4; int main() { int a = g; print(a * (1 - 1), 7 - 2); return 0; }";
+    AnalyseError err;
+    const FileASTPtr file = Analyse(s, err);
+    REQUIRE(!err);
+
+    // passes with their own attributes run concurrently over one tree
+    const std::size_t N = 4;
+    std::vector<DepthPass> depths(N, DepthPass(*file));
+    std::vector<ConstIntPass> consts(N, ConstIntPass(*file));
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        threads.emplace_back([&, i]() { depths[i].Visit(*file); });
+        threads.emplace_back([&, i]() { consts[i].Visit(*file); });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    const auto& init = *file->GetVars()[0]->GetExpr();
+    const auto print = static_cast<PrintStmtASTPtr>(file->GetFuncs()[0]->GetBlockStmt()->GetStmts()[0]);
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        CHECK(depths[i].depth[*file] == 0);
+        CHECK(depths[i].depth[*file->GetVars()[0]] == 1);
+        // initializer of a variable has the parent of the variable
+        CHECK(depths[i].depth[init] == 1);
+        CHECK(depths[i].depth[*print->GetParams()[1]] == 4);
+
+        CHECK(consts[i].isConst[init]);
+        CHECK(consts[i].value[init] == 14);
+        CHECK(!consts[i].isConst[*print->GetParams()[0]]);
+        CHECK(consts[i].value[*print->GetParams()[1]] == 5);
+    }
+
+    // node created after the attribute gets the default value
+    ASTAttribute<int> attr(*file, 9);
+    auto node = file->GetContext().New<IntExprAST>(nullptr, 1);
+    CHECK(static_cast<const ASTAttribute<int>&>(attr)[*node] == 9);
+    attr[*node] = 3;
+    CHECK(attr[*node] == 3);
+    CHECK(attr.GetSize() == node->GetId() + 1);
+}
+
+TEST_CASE("frozen ast")
+{
+    std::string s = R"(
+int g = 1;
+double d = 2.5;
+
+int f(int n)
+{
+    int i;
+    for (i = 0; i < n; i = i + 1)
+        g = g + i * 2;
+    return n + g;
+}
+
+int main()
+{
+    char c = 'a';
+    print(f(2), d * c);
+    return 0;
+}
+)";
+    const auto tokens = Tokenize(s);
+    AnalyseError err;
+    auto file = Analyser(tokens).Analyse(err);
+    REQUIRE(!err);
+    file->Freeze();
+    CHECK(file->IsFrozen());
+    CHECK_THROWS_AS(file->GetContext().New<IntExprAST>(nullptr, 1), std::logic_error);
+    CHECK_THROWS_AS(file->AddVar(nullptr), std::logic_error);
+    CHECK_THROWS_AS(file->GetContext().Rewind(file->GetContext().GetMark()), std::logic_error);
+
+    // frozen file is never changed by reanalyse
+    const auto before = file->ToString();
+    auto newfile = Analyser(tokens).Reanalyse(file, tokens, posrange_t(pos_t(5, 0), pos_t(5, 1)), err);
+    CHECK(!err);
+    CHECK(newfile != file);
+    CHECK(!newfile->IsFrozen());
+    CHECK(file->ToString() == before);
+
+    // read-only passes run concurrently on one frozen tree
+    struct Result
+    {
+        std::string text;
+        std::vector<std::size_t> indexes;
+        std::size_t ints = 0;
+        std::vector<VarType> types;
+        SymbolType symbol = SymbolType::Nul;
+    };
+    auto run = [&](Result& r)
+    {
+        const ConstFileASTPtr frozen = file;
+        r.text = frozen->ToString();
+        TokenIndexCollector collector;
+        frozen->Accept(collector);
+        r.indexes = collector.indexes;
+        StaticIntExprCounter counter;
+        counter.Visit(*frozen);
+        r.ints = counter.count;
+        r.symbol = frozen->GetFuncs()[0]->GetBlockStmt()->GetSymbolType("g", true);
+        const auto print = static_cast<PrintStmtASTPtr>(frozen->GetFuncs()[1]->GetBlockStmt()->GetStmts()[0]);
+        for (const auto& param : print->GetParams())
+            r.types.push_back(param->GetVarType());
+    };
+
+    Result expected;
+    run(expected);
+    CHECK(expected.symbol == SymbolType::Var);
+    CHECK(expected.types == std::vector<VarType>{ VarType::Int, VarType::Float });
+
+    std::vector<Result> results(8);
+    std::vector<std::thread> threads;
+    for (auto& r : results)
+        threads.emplace_back(run, std::ref(r));
+    for (auto& t : threads)
+        t.join();
+    for (const auto& r : results)
+    {
+        CHECK(r.text == expected.text);
+        CHECK(r.indexes == expected.indexes);
+        CHECK(r.ints == expected.ints);
+        CHECK(r.types == expected.types);
+        CHECK(r.symbol == expected.symbol);
+    }
+}
+
+TEST_CASE("destroy deep ast")
+{
+    // left-leaning chain 1 + 1 + ... of one million nodes
+    const std::size_t N = 500000;
+    auto file = std::make_shared<FileAST>(nullptr);
+    auto& context = file->GetContext();
+    auto var = context.New<VarDeclAST>(file.get(), false, false, VarType::Int, "a");
+    ExprASTPtr expr = context.New<IntExprAST>(nullptr, 1);
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        auto right = context.New<IntExprAST>(nullptr, 1);
+        auto add = context.New<BinaryExprAST>(file.get(), expr, BinaryType::Add, right);
+        expr->SetParent(add);
+        right->SetParent(add);
+        expr = add;
+    }
+    var->SetExpr(expr);
+    file->AddVar(var);
+    CHECK(context.GetNodeCount() == 2 * N + 2);
+
+    const auto beg = std::chrono::steady_clock::now();
+    file = nullptr;
+    const auto elapsed = std::chrono::steady_clock::now() - beg;
+    CHECK(elapsed < std::chrono::seconds(2));
+}
+
+TEST_CASE("small vector")
+{
+    SmallVector<int, 2> v;
+    CHECK(v.empty());
+    v.push_back(1);
+    v.push_back(2);
+    CHECK(v.IsInline());
+    v.push_back(v[0]);
+    CHECK(!v.IsInline());
+    CHECK(v == SmallVector<int, 2>{ 1, 2, 1 });
+
+    v.insert(v.begin() + 1, 5);
+    v.erase(v.begin());
+    CHECK(v == SmallVector<int, 2>{ 5, 2, 1 });
+
+    auto w = std::move(v);
+    CHECK(v.empty());
+    CHECK(v.IsInline());
+    CHECK(w.size() == 3);
+    v = w;
+    CHECK(v == w);
+    w.resize(1);
+    v = std::move(w);
+    CHECK(v == SmallVector<int, 2>(1, 5));
+
+    AnalyseError err;
+    auto file = Analyse("int f(int a, int b) { print(a, b); return a; } int main() { return f(1, 2); }", err);
+    REQUIRE(!err);
+    CHECK(file->GetFuncs()[0]->GetParams().IsInline());
+    const auto print = static_cast<PrintStmtASTPtr>(file->GetFuncs()[0]->GetBlockStmt()->GetStmts()[0]);
+    CHECK(print->GetParams().IsInline());
+}
+
+TEST_CASE("flat ast")
+{
+    CHECK(sizeof(FlatNode) == 16);
+
+    std::string s = R"(
+const char C = 'x';
+double d = 1.5, e;
+int g;
+
+void show(int a, double b)
+{
+    print(a, "b=", b);
+}
+
+int main()
+{
+    int i;
+    char c = 'a';
+    const double k = 2.0 * 3;
+    for (i = 0, g = 1; i < 10; i = i + 1, show(i, d))
+    {
+        switch (c)
+        {
+        case 'a':
+            c = c + 1;
+        case 2:
+            break;
+        default:
+            c = 'z';
+        }
+        if (d)
+            e = (int)d / 2;
+        else
+            return 1;
+        do
+            i = i + 1;
+        while (i < 3);
+    }
+    while (i > 0)
+    {
+        i = i - 1;
+        continue;
+    }
+    scan(g);
+    show(-g, -d);
+    return (int)(k + C);
+}
+)";
+    AnalyseError err;
+    auto file = Analyse(s, err);
+    REQUIRE(!err);
+
+    FlatAST flat(*file);
+    const auto& nodes = flat.GetNodes();
+    REQUIRE(!nodes.empty());
+    CHECK(nodes[0].GetASTType() == ASTType::File);
+    CHECK(flat.GetNextSibling(0) == nodes.size());
+    CHECK(flat.GetChildCount(0) == file->GetVars().size() + file->GetFuncs().size());
+
+    // pass over the whole file is a linear scan
+    std::size_t ints = 0;
+    for (const auto& node : nodes)
+        if (node.GetASTType() == ASTType::IntExpr)
+            ++ints;
+    IntExprCounter counter;
+    file->Accept(counter);
+    CHECK(ints == counter.count);
+
+    // round trip
+    auto tree = flat.ToTree();
+    CHECK(tree->ToString() == file->ToString());
+    TokenIndexCollector before, after;
+    file->Accept(before);
+    tree->Accept(after);
+    CHECK(before.indexes == after.indexes);
+    CHECK(FlatAST(*tree).GetNodes().size() == nodes.size());
+}
+
+TEST_SUITE_END();